@@ -3,8 +3,10 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <memory>
+#include <cstdint>
 #include "TopTagger/CfgParser/include/Parameter.hh"
 //#include "log4cplus/logger.h"
 
@@ -19,6 +21,15 @@ namespace cfg {
 
         static std::unique_ptr<CfgDocument> parseDocument(const std::string& text);
 
+        /// serialize the resolved parameters into a binary snapshot which can be loaded without parsing (conditional parameters can not be stored)
+        std::string snapshot() const;
+        /// does the data start with the snapshot header?
+        static bool isSnapshot(const std::string& data);
+        /// content hash of the parameters stored in a snapshot
+        static uint64_t snapshotHash(const std::string& data);
+        /// load a document from a snapshot, the content hash is checked against the stored parameters
+        static std::unique_ptr<CfgDocument> loadSnapshot(const std::string& data);
+
         void useRecord(Record*);
 
         Condition* addCondition();
@@ -34,6 +45,12 @@ namespace cfg {
         std::string get(const std::string& name, int index, const Context& cxt, const char* defl) const;
         std::string get(const std::string& name, int index, const Context& cxt, const std::string& defl) const;
 
+        /// get the elements name[0], name[1], ... of an array parameter up to the first missing element
+        void getArray(const std::string& name, const Context& cxt, std::vector<int>& values) const;
+        void getArray(const std::string& name, const Context& cxt, std::vector<double>& values) const;
+        void getArray(const std::string& name, const Context& cxt, std::vector<bool>& values) const;
+        void getArray(const std::string& name, const Context& cxt, std::vector<std::string>& values) const;
+
         // access internal values (as needed)
         typedef std::map<std::string, std::unique_ptr<Parameter>>::const_iterator param_itr;
         param_itr param_begin() const { return m_parameters.begin(); }
@@ -44,9 +61,23 @@ namespace cfg {
         void postValueUsed(const std::string& name, const Context& cxt, const std::string& value);
         void postValueUsed(const std::string& name, const Context& cxt, bool value);
     private:      
+        /// index entry for one parameter name in a namespace, array elements name[i] are also collected under name
+        struct IndexEntry {
+            IndexEntry() : param(0) { }
+            const Parameter* param;
+            std::vector<const Parameter*> elements;
+        };
+        typedef std::unordered_map<std::string, IndexEntry> NamespaceIndex;
+
         Literal get(const std::string& name, const Context& cxt, const Literal& defl) const;
+        Literal get(const std::string& name, int index, const Context& cxt, const Literal& defl) const;
+        Literal resolve(const Parameter* param, const std::string& name, int index, const Context& cxt, const Literal& defl) const;
+        void getArray(const std::string& name, const Context& cxt, std::vector<Literal>& values) const;
+        const IndexEntry* findEntry(const std::string& ns, const std::string& name) const;
+        void indexParameter(const Parameter* param);
         std::string makeKey(const std::string& ns, const std::string& name) const;
         std::map<std::string, std::unique_ptr<Parameter>> m_parameters;
+        std::unordered_map<std::string, NamespaceIndex> m_index; // capitalized namespace -> capitalized name -> parameters
         std::vector<Condition*> m_conditions; // owner of all conditions
         Record* m_recordPtr; // not to be deleted!
         //log4cplus::Logger m_logger;
@@ -4,6 +4,122 @@
 #include "TopTagger/CfgParser/include/TTException.h"
 #include "TopTagger/CfgParser/include/Scanner.h"
 #include "TopTagger/CfgParser/include/Parser.h"
+#include "TopTagger/CfgParser/include/Context.hh"
+
+#include <cstring>
+#include <cctype>
+
+namespace
+{
+    //Snapshot layout: magic, format version, number of parameters, FNV-1a hash of the payload, payload
+    //Each parameter in the payload is stored as namespace, name, literal flavor and value, all numbers are little endian
+    const char snapshotMagic[] = "TTCFGSNP";
+    const size_t snapshotMagicSize = 8;
+    const uint32_t snapshotVersion = 1;
+    const size_t snapshotHeaderSize = snapshotMagicSize + 4 + 4 + 8;
+
+    uint64_t fnv1aHash(const char* data, size_t size)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for(size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    void writeUInt(std::string& out, uint64_t value, int nBytes)
+    {
+        for(int i = 0; i < nBytes; ++i) out.push_back(static_cast<char>((value >> (8*i)) & 0xff));
+    }
+
+    void writeString(std::string& out, const std::string& str)
+    {
+        writeUInt(out, str.size(), 4);
+        out += str;
+    }
+
+    //Conversion of parameter values to the requested type
+    int toInt(const cfg::Literal& l)
+    {
+        if (l.flavor()!=cfg::Literal::fl_Integer) 
+        {
+            //XCEPT_RAISE(hcal::exception::CfgLanguageException,"Type mismatch (expected int)");
+            //throw "CfgLanguageException: Type mismatch (expected int)";
+            THROW_TTEXCEPTION("CfgLanguageException: Type mismatch (expected int)");
+        }
+        return l.intValue();
+    }
+
+    double toFloat(const cfg::Literal& l)
+    {
+        if(l.flavor() == cfg::Literal::fl_Float) 
+        {
+            return l.floatValue();
+        }
+        else if(l.flavor() == cfg::Literal::fl_Integer)
+        {
+            return static_cast<double>(l.intValue());
+        }
+        else
+        {
+            //XCEPT_RAISE(hcal::exception::CfgLanguageException,"Type mismatch (expected int)");
+            //throw "CfgLanguageException: Type mismatch (expected float)";
+            THROW_TTEXCEPTION("CfgLanguageException: Type mismatch (expected float)");
+        }
+    }
+
+    bool toBool(const cfg::Literal& l)
+    {
+        if (l.flavor()!=cfg::Literal::fl_Boolean) {
+            //XCEPT_RAISE(hcal::exception::CfgLanguageException,"Type mismatch (expected bool)");
+            //throw "CfgLanguageException: Type mismatch (expected bool)";
+            THROW_TTEXCEPTION("CfgLanguageException: Type mismatch (expected bool)");
+        }
+        return l.boolValue();
+    }
+
+    std::string toString(const cfg::Literal& l)
+    {
+        if (l.flavor()!=cfg::Literal::fl_String) {
+            //XCEPT_RAISE(hcal::exception::CfgLanguageException,"Type mismatch (expected string)");
+            //throw "CfgLanguageException: Type mismatch (expected string)";
+            THROW_TTEXCEPTION("CfgLanguageException: Type mismatch (expected string)");
+        }
+        return l.strValue();
+    }
+
+    class SnapshotReader
+    {
+    private:
+        const std::string& data_;
+        size_t pos_;
+
+    public:
+        SnapshotReader(const std::string& data, size_t pos) : data_(data), pos_(pos) {}
+
+        bool atEnd() const { return pos_ == data_.size(); }
+
+        uint64_t readUInt(int nBytes)
+        {
+            if(data_.size() - pos_ < static_cast<size_t>(nBytes)) THROW_TTEXCEPTION("Truncated configuration snapshot");
+            uint64_t value = 0;
+            for(int i = 0; i < nBytes; ++i) value |= static_cast<uint64_t>(static_cast<unsigned char>(data_[pos_ + i])) << (8*i);
+            pos_ += nBytes;
+            return value;
+        }
+
+        std::string readString()
+        {
+            size_t size = readUInt(4);
+            if(data_.size() - pos_ < size) THROW_TTEXCEPTION("Truncated configuration snapshot");
+            std::string str = data_.substr(pos_, size);
+            pos_ += size;
+            return str;
+        }
+    };
+}
 
 namespace cfg {
 
@@ -28,6 +144,102 @@ namespace cfg {
         }
     }
 
+    std::string CfgDocument::snapshot() const
+    {
+        std::string payload;
+        for (param_itr i=m_parameters.begin(); i!=m_parameters.end(); i++)
+        {
+            const Parameter& param = *(i->second);
+            if(!param.conditionalItems().empty())
+            {
+                THROW_TTEXCEPTION("Parameter \"" + param.ns() + "::" + param.name() + "\" has conditional assignments and can not be stored in a snapshot");
+            }
+
+            //Without conditions the last assignment is the resolved value
+            Literal l=param.valueInContext(Context(param.ns()),true);
+            writeString(payload, param.ns());
+            writeString(payload, param.name());
+            writeUInt(payload, l.flavor(), 1);
+            switch (l.flavor()) {
+            case (Literal::fl_Null) : break;
+            case (Literal::fl_String) : writeString(payload, l.strValue()); break;
+            case (Literal::fl_Boolean) : writeUInt(payload, l.boolValue(), 1); break;
+            case (Literal::fl_Integer) : writeUInt(payload, static_cast<uint32_t>(l.intValue()), 4); break;
+            case (Literal::fl_Float) :
+            {
+                double value = l.floatValue();
+                uint64_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                writeUInt(payload, bits, 8);
+                break;
+            }
+            }
+        }
+
+        std::string data(snapshotMagic, snapshotMagicSize);
+        writeUInt(data, snapshotVersion, 4);
+        writeUInt(data, m_parameters.size(), 4);
+        writeUInt(data, fnv1aHash(payload.data(), payload.size()), 8);
+        return data + payload;
+    }
+
+    bool CfgDocument::isSnapshot(const std::string& data)
+    {
+        return data.size() >= snapshotHeaderSize && data.compare(0, snapshotMagicSize, snapshotMagic) == 0;
+    }
+
+    uint64_t CfgDocument::snapshotHash(const std::string& data)
+    {
+        if(!isSnapshot(data)) THROW_TTEXCEPTION("Data is not a configuration snapshot");
+        return SnapshotReader(data, snapshotMagicSize + 8).readUInt(8);
+    }
+
+    std::unique_ptr<CfgDocument> CfgDocument::loadSnapshot(const std::string& data)
+    {
+        if(!isSnapshot(data)) THROW_TTEXCEPTION("Data is not a configuration snapshot");
+
+        SnapshotReader header(data, snapshotMagicSize);
+        uint32_t version = header.readUInt(4);
+        uint32_t nParameters = header.readUInt(4);
+        uint64_t hash = header.readUInt(8);
+        if(version != snapshotVersion)
+        {
+            THROW_TTEXCEPTION("Unsupported configuration snapshot version " + std::to_string(version));
+        }
+        if(hash != fnv1aHash(data.data() + snapshotHeaderSize, data.size() - snapshotHeaderSize))
+        {
+            THROW_TTEXCEPTION("Configuration snapshot content hash mismatch");
+        }
+
+        std::unique_ptr<CfgDocument> doc(new CfgDocument());
+        SnapshotReader reader(data, snapshotHeaderSize);
+        for(uint32_t iParam = 0; iParam < nParameters; ++iParam)
+        {
+            std::string ns = reader.readString();
+            std::string name = reader.readString();
+            Literal l;
+            switch (reader.readUInt(1)) {
+            case (Literal::fl_Null) : break;
+            case (Literal::fl_String) : l=Literal(reader.readString()); break;
+            case (Literal::fl_Boolean) : l=Literal(reader.readUInt(1) != 0); break;
+            case (Literal::fl_Integer) : l=Literal(static_cast<int>(static_cast<uint32_t>(reader.readUInt(4)))); break;
+            case (Literal::fl_Float) :
+            {
+                uint64_t bits = reader.readUInt(8);
+                double value;
+                memcpy(&value, &bits, sizeof(value));
+                l=Literal(value);
+                break;
+            }
+            default : THROW_TTEXCEPTION("Unknown literal flavor in configuration snapshot");
+            }
+            doc->assignParameter(ns, name, ConditionChain(), l);
+        }
+        if(!reader.atEnd()) THROW_TTEXCEPTION("Unexpected data at the end of configuration snapshot");
+
+        return doc;
+    }
+
     CfgDocument::~CfgDocument() {
         //for (std::map<std::string, Parameter*>::iterator i=m_parameters.begin(); i!=m_parameters.end(); i++)
         //    delete i->second;
@@ -50,131 +262,160 @@ namespace cfg {
         if (i==m_parameters.end()) {
             m_parameters.insert(std::pair<std::string,std::unique_ptr<Parameter>>(key,std::unique_ptr<Parameter>(new Parameter(ns,name))));
             i=m_parameters.find(key);
+            indexParameter(i->second.get());
         }
         i->second->addAssignment(cc,l);
     }
 
-    Literal CfgDocument::get(const std::string& name, const Context& cxt, const Literal& defl) const
+    void CfgDocument::indexParameter(const Parameter* param)
     {
-        std::string key=makeKey(cxt.ns(),name);
-        std::map<std::string, std::unique_ptr<Parameter>>::const_iterator i=m_parameters.find(key);
-        if (i==m_parameters.end()) 
+        NamespaceIndex& nsIndex=m_index[capitalize(param->ns())];
+        std::string name=capitalize(param->name());
+        nsIndex[name].param=param;
+
+        //array elements "name[i]" are also stored by index under "name"
+        std::string::size_type open=name.rfind('[');
+        if (open==std::string::npos || open==0 || open+2>=name.size() || name[name.size()-1]!=']') return;
+        //only the form written by "[%d]" is an element, so "name[01]" stays a separate parameter
+        if (name[open+1]=='0' && open+3<name.size()) return;
+        //bound the index before converting it, the element vector is sized by it
+        const std::string::size_type maxDigits=6;
+        const int maxIndex=100000;
+        bool tooLong=(name.size()-open-2>maxDigits);
+        int index=0;
+        for (std::string::size_type i=open+1; i<name.size()-1; i++)
         {
-            if (m_recordPtr!=0) m_recordPtr->record(cxt, name, defl, true);
-            return defl;
-        } 
-        else
+            if (!isdigit(name[i])) return;
+            if (!tooLong) index=10*index+(name[i]-'0');
+        }
+        if (tooLong || index>maxIndex) THROW_TTEXCEPTION("CfgLanguageException: Array index of parameter \"" + param->ns() + "::" + param->name() + "\" exceeds the maximum of " + std::to_string(maxIndex));
+        IndexEntry& entry=nsIndex[name.substr(0,open)];
+        if (entry.elements.size()<=static_cast<size_t>(index)) entry.elements.resize(index+1,0);
+        entry.elements[index]=param;
+    }
+
+    const CfgDocument::IndexEntry* CfgDocument::findEntry(const std::string& ns, const std::string& name) const
+    {
+        std::unordered_map<std::string, NamespaceIndex>::const_iterator i=m_index.find(capitalize(ns));
+        if (i==m_index.end()) return 0;
+        NamespaceIndex::const_iterator j=i->second.find(capitalize(name));
+        if (j==i->second.end()) return 0;
+        return &(j->second);
+    }
+
+    Literal CfgDocument::resolve(const Parameter* param, const std::string& name, int index, const Context& cxt, const Literal& defl) const
+    {
+        Literal l;
+        if (param!=0) l=param->valueInContext(cxt,true);
+        bool usedDefault=(l.flavor()==Literal::fl_Null);
+        if (usedDefault) l=defl;
+        if (m_recordPtr!=0) 
         {
-            Literal l=i->second->valueInContext(cxt,true);
-            if (l.flavor()==Literal::fl_Null) 
+            std::string fullName(name);
+            if (index>=0)
             {
-                l=defl;
-                if (m_recordPtr!=0) m_recordPtr->record(cxt, name, defl, true);
+                char text[20];
+                snprintf(text,20,"[%d]",index);
+                fullName+=text;
             }
-            else if (m_recordPtr!=0) m_recordPtr->record(cxt, name, l, false);
-            return l;
+            m_recordPtr->record(cxt, fullName, l, usedDefault);
         }
+        return l;
     }
 
-    int CfgDocument::get(const std::string& name, const Context& cxt, int defl) const
+    Literal CfgDocument::get(const std::string& name, const Context& cxt, const Literal& defl) const
     {
-        Literal l=get(name,cxt,Literal(defl));
-        if (l.flavor()!=Literal::fl_Integer) 
+        const IndexEntry* entry=findEntry(cxt.ns(),name);
+        return resolve(entry ? entry->param : 0, name, -1, cxt, defl);
+    }
+
+    Literal CfgDocument::get(const std::string& name, int index, const Context& cxt, const Literal& defl) const
+    {
+        const IndexEntry* entry=findEntry(cxt.ns(),name);
+        const Parameter* param=0;
+        if (entry!=0 && index>=0 && static_cast<size_t>(index)<entry->elements.size()) param=entry->elements[index];
+        return resolve(param, name, index, cxt, defl);
+    }
+
+    void CfgDocument::getArray(const std::string& name, const Context& cxt, std::vector<Literal>& values) const
+    {
+        values.clear();
+        const IndexEntry* entry=findEntry(cxt.ns(),name);
+        if (entry==0) return;
+        for (size_t i=0; i<entry->elements.size() && entry->elements[i]!=0; i++)
         {
-            //XCEPT_RAISE(hcal::exception::CfgLanguageException,"Type mismatch (expected int)");
-            //throw "CfgLanguageException: Type mismatch (expected int)";
-            THROW_TTEXCEPTION("CfgLanguageException: Type mismatch (expected int)");
+            Literal l=resolve(entry->elements[i], name, i, cxt, Literal());
+            if (l.flavor()==Literal::fl_Null) break;
+            values.push_back(l);
         }
-        return l.intValue();
+    }
+
+    int CfgDocument::get(const std::string& name, const Context& cxt, int defl) const
+    {
+        return toInt(get(name,cxt,Literal(defl)));
     }
     
     double CfgDocument::get(const std::string& name, const Context& cxt, double defl) const
     {
-        Literal l=get(name,cxt,Literal(defl));
-        
-        if(l.flavor() == Literal::fl_Float) 
-        {
-            return l.floatValue();
-        }
-        else if(l.flavor() == Literal::fl_Integer)
-        {
-            return static_cast<double>(l.intValue());
-        }
-        else
-        {
-            //XCEPT_RAISE(hcal::exception::CfgLanguageException,"Type mismatch (expected int)");
-            //throw "CfgLanguageException: Type mismatch (expected float)";
-            THROW_TTEXCEPTION("CfgLanguageException: Type mismatch (expected float)");
-        }
-        
+        return toFloat(get(name,cxt,Literal(defl)));
     }
 
     bool CfgDocument::get(const std::string& name, const Context& cxt, bool defl) const {
-        Literal l=get(name,cxt,Literal(defl));
-        if (l.flavor()!=Literal::fl_Boolean) {
-            //XCEPT_RAISE(hcal::exception::CfgLanguageException,"Type mismatch (expected bool)");
-            //throw "CfgLanguageException: Type mismatch (expected bool)";
-            THROW_TTEXCEPTION("CfgLanguageException: Type mismatch (expected bool)");
-        }
-        return l.boolValue();
+        return toBool(get(name,cxt,Literal(defl)));
     }
     std::string CfgDocument::get(const std::string& name, const Context& cxt, const std::string& defl) const {
-        Literal l=get(name,cxt,Literal(defl));
-        if (l.flavor()!=Literal::fl_String) {
-            //XCEPT_RAISE(hcal::exception::CfgLanguageException,"Type mismatch (expected string)");
-            //throw "CfgLanguageException: Type mismatch (expected string)";
-            THROW_TTEXCEPTION("CfgLanguageException: Type mismatch (expected string)");
-        }
-        return l.strValue();
+        return toString(get(name,cxt,Literal(defl)));
     }
     std::string CfgDocument::get(const std::string& name, const Context& cxt, const char* defl) const {
-        Literal l=get(name,cxt,Literal(defl));
-        if (l.flavor()!=Literal::fl_String) {
-            //XCEPT_RAISE(hcal::exception::CfgLanguageException,"Type mismatch (expected string)");
-            //throw "CfgLanguageException: Type mismatch (expected string)";
-            THROW_TTEXCEPTION("CfgLanguageException: Type mismatch (expected string)");
-        }
-        return l.strValue();
+        return toString(get(name,cxt,Literal(defl)));
     }
 
     int CfgDocument::get(const std::string& name, int index, const Context& cxt, int defl) const {
-        std::string fullName(name);
-        char text[20];
-        snprintf(text,20,"[%d]",index);
-        fullName+=text;
-        return get(fullName,cxt,defl);
+        return toInt(get(name,index,cxt,Literal(defl)));
     }
 
     double CfgDocument::get(const std::string& name, int index, const Context& cxt, double defl) const {
-        std::string fullName(name);
-        char text[20];
-        snprintf(text,20,"[%d]",index);
-        fullName+=text;
-        return get(fullName,cxt,defl);
+        return toFloat(get(name,index,cxt,Literal(defl)));
     }
 
     std::string CfgDocument::get(const std::string& name, int index, const Context& cxt, const std::string& defl) const {
-        std::string fullName(name);
-        char text[20];
-        snprintf(text,20,"[%d]",index);
-        fullName+=text;
-        return get(fullName,cxt,defl);
+        return toString(get(name,index,cxt,Literal(defl)));
     }
 
     std::string CfgDocument::get(const std::string& name, int index, const Context& cxt, const char* defl) const {
-        std::string fullName(name);
-        char text[20];
-        snprintf(text,20,"[%d]",index);
-        fullName+=text;
-        return get(fullName,cxt,defl);
+        return toString(get(name,index,cxt,Literal(defl)));
     }
 
     bool CfgDocument::get(const std::string& name, int index, const Context& cxt, bool defl) const {
-        std::string fullName(name);
-        char text[20];
-        snprintf(text,20,"[%d]",index);
-        fullName+=text;
-        return get(fullName,cxt,defl);
+        return toBool(get(name,index,cxt,Literal(defl)));
+    }
+
+    void CfgDocument::getArray(const std::string& name, const Context& cxt, std::vector<int>& values) const {
+        std::vector<Literal> literals;
+        getArray(name,cxt,literals);
+        values.clear();
+        for (std::vector<Literal>::const_iterator i=literals.begin(); i!=literals.end(); i++) values.push_back(toInt(*i));
+    }
+
+    void CfgDocument::getArray(const std::string& name, const Context& cxt, std::vector<double>& values) const {
+        std::vector<Literal> literals;
+        getArray(name,cxt,literals);
+        values.clear();
+        for (std::vector<Literal>::const_iterator i=literals.begin(); i!=literals.end(); i++) values.push_back(toFloat(*i));
+    }
+
+    void CfgDocument::getArray(const std::string& name, const Context& cxt, std::vector<bool>& values) const {
+        std::vector<Literal> literals;
+        getArray(name,cxt,literals);
+        values.clear();
+        for (std::vector<Literal>::const_iterator i=literals.begin(); i!=literals.end(); i++) values.push_back(toBool(*i));
+    }
+
+    void CfgDocument::getArray(const std::string& name, const Context& cxt, std::vector<std::string>& values) const {
+        std::vector<Literal> literals;
+        getArray(name,cxt,literals);
+        values.clear();
+        for (std::vector<Literal>::const_iterator i=literals.begin(); i!=literals.end(); i++) values.push_back(toString(*i));
     }
 
 
@@ -0,0 +1,180 @@
+#Convert a frozen tensorflow MLP graph (as produced by CreateModel.saveModel) into the
+#binary weight file read by the TTMNativeDNN module.  The input offset/scale and all
+#batch normalization layers are folded into the weights of the dense layers.  Optionally the
+#fixed calibration set used by TTMNativeDNN to correct its reduced precision arithmetic is
+#written alongside the model.
+
+from __future__ import print_function
+
+import re
+import struct
+import optparse
+import numpy as np
+import tensorflow as tf
+from tensorflow.python.framework import tensor_util
+
+#Must match the Activation enum in TTMNativeDNN.h
+ACTIVATIONS = {"none": 0, "relu": 1, "sigmoid": 2, "tanh": 3, "softmax": 4}
+
+parser = optparse.OptionParser("usage: %prog [options]\n")
+
+parser.add_option ('-i', "--input",      dest='input',      action='store',      default="tfModel_frozen.pb", help="Frozen tensorflow graph")
+parser.add_option ('-o', "--output",     dest='output',     action='store',      default="nativeModel.dnn",   help="Output file for TTMNativeDNN")
+parser.add_option ('-a', "--activation", dest='activation', action='store',      default=None,                help="Hidden layer activation (relu, sigmoid, tanh, none), by default this is taken from the graph")
+parser.add_option ('-e', "--epsilon",    dest='epsilon',    action='store',      default=None, type=float,    help="Batch normalization epsilon, by default this is taken from the graph")
+parser.add_option ('-c', "--check",      dest='check',      action='store_true', default=False,               help="Compare the converted network to tensorflow on random inputs")
+parser.add_option ('--inputOp',          dest='inputOp',    action='store',      default="x",                 help="Input operation for the tensorflow graph")
+parser.add_option ('--outputOp',         dest='outputOp',   action='store',      default="y_ph",              help="Output operation of the tensorflow graph")
+parser.add_option ('--calibInput',       dest='calibInput', action='store',      default=None,                help="numpy (.npy) file of calibration candidates, one row per candidate holding the candidate pt followed by the mvaVar inputs")
+parser.add_option ('--calibOutput',      dest='calibOutput',action='store',      default="nativeModel.cal",   help="Output calibration file for TTMNativeDNN (calibrationFile)")
+
+options, args = parser.parse_args()
+
+def loadGraphDef(fname):
+    graph_def = tf.GraphDef()
+    with tf.gfile.GFile(fname, "rb") as f:
+        graph_def.ParseFromString(f.read())
+    return graph_def
+
+def findConst(consts, pattern, required=True):
+    matches = [name for name in consts if re.search(pattern, name)]
+    if len(matches) == 0:
+        if required:
+            raise RuntimeError("No constant matching \"%s\" found in graph"%pattern)
+        return None
+    #prefer the shortest name, the copy of the network used for training has the same variables
+    return consts[sorted(matches, key=len)[0]]
+
+def findOpType(graph_def, pattern):
+    for node in graph_def.node:
+        if re.search(pattern, node.name):
+            return node.op
+    return None
+
+def batchNormCoefficients(consts, layer, nNodes, epsilon):
+    prefix = r"(^|/)layer%i_bn/"%layer
+    mean  = findConst(consts, prefix + r"moving_mean$", required=False)
+    if mean is None:
+        return np.ones(nNodes, dtype=np.float64), np.zeros(nNodes, dtype=np.float64)
+    var   = findConst(consts, prefix + r"moving_variance$")
+    gamma = findConst(consts, prefix + r"gamma$", required=False)
+    beta  = findConst(consts, prefix + r"beta$", required=False)
+    if gamma is None: gamma = np.ones(nNodes)
+    if beta  is None: beta  = np.zeros(nNodes)
+    s = gamma/np.sqrt(var + epsilon)
+    return s, beta - mean*s
+
+def buildNetwork(graph_def):
+    consts = {}
+    for node in graph_def.node:
+        if node.op == "Const":
+            consts[node.name] = tensor_util.MakeNdarray(node.attr["value"].tensor).astype(np.float64)
+
+    if any(re.search(r"(^|/)(cnn|rnn)/", node.name) for node in graph_def.node):
+        raise RuntimeError("Convolutional and recurrent layers are not supported by TTMNativeDNN")
+
+    #batch normalization epsilon
+    epsilon = options.epsilon
+    if epsilon is None:
+        eps = findConst(consts, r"layer0_bn/batchnorm/add/y$", required=False)
+        epsilon = float(eps) if eps is not None else 1.0e-3
+
+    #hidden layer activation
+    activation = options.activation
+    if activation is None:
+        opType = findOpType(graph_def, r"(^|/)h_fc1(_ph)?$")
+        activation = {"Relu": "relu", "Sigmoid": "sigmoid", "Tanh": "tanh"}.get(opType, "none")
+
+    #the domain adaption layer is not used by the output op and is pruned by freeze_graph
+    weightIdx = sorted(int(re.search(r"w_fc(\d+)$", name).group(1)) for name in consts if re.search(r"(^|/)w_fc\d+$", name))
+    if len(weightIdx) == 0 or weightIdx != list(range(len(weightIdx))):
+        raise RuntimeError("Unable to find dense layer weights in graph")
+
+    nInputs = findConst(consts, r"(^|/)w_fc0$").shape[0]
+
+    #input transformation x' = (x - offset)*scale followed by batch normalization of the inputs
+    offset = findConst(consts, r"^offset$", required=False)
+    scale  = findConst(consts, r"^scale$",  required=False)
+    if offset is None: offset = np.zeros(nInputs)
+    if scale  is None: scale  = np.ones(nInputs)
+    s0, c0 = batchNormCoefficients(consts, 0, nInputs, epsilon)
+    inScale = scale*s0
+    inShift = -offset*scale*s0 + c0
+
+    layers = []
+    for i in weightIdx:
+        w = findConst(consts, r"(^|/)w_fc%i$"%i)
+        b = findConst(consts, r"(^|/)b_fc%i$"%i)
+        if i == 0:
+            b = b + inShift.dot(w)
+            w = w*inScale[:, np.newaxis]
+        if i == weightIdx[-1]:
+            layers.append((w, b, "softmax"))
+        else:
+            s, c = batchNormCoefficients(consts, i + 1, w.shape[1], epsilon)
+            layers.append((w*s[np.newaxis, :], b*s + c, activation))
+
+    return layers
+
+def writeNetwork(layers, fname):
+    with open(fname, "wb") as f:
+        f.write(struct.pack("<8sII", b"TTDNN\0\0\0", 1, len(layers)))
+        for w, b, act in layers:
+            f.write(struct.pack("<III", w.shape[0], w.shape[1], ACTIVATIONS[act]))
+            f.write(np.ascontiguousarray(w, dtype="<f4").tobytes())
+            f.write(np.ascontiguousarray(b, dtype="<f4").tobytes())
+
+def writeCalibration(layers, cands, fname):
+    nInputs = layers[0][0].shape[0]
+    if cands.ndim != 2 or cands.shape[1] != nInputs + 1:
+        raise RuntimeError("Calibration candidates must have shape (nCand, %i), the candidate pt followed by the %i inputs"%(nInputs + 1, nInputs))
+    with open(fname, "wb") as f:
+        f.write(struct.pack("<8sIII", b"TTDNNCAL", 1, cands.shape[0], nInputs))
+        f.write(np.ascontiguousarray(cands[:, 0], dtype="<f4").tobytes())
+        f.write(np.ascontiguousarray(cands[:, 1:], dtype="<f4").tobytes())
+
+def evaluate(layers, x):
+    h = x.astype(np.float32)
+    for w, b, act in layers:
+        h = h.dot(w.astype(np.float32)) + b.astype(np.float32)
+        if   act == "relu":    h = np.maximum(h, 0)
+        elif act == "sigmoid": h = 1/(1 + np.exp(-h))
+        elif act == "tanh":    h = np.tanh(h)
+        elif act == "softmax":
+            h = np.exp(h - h.max(axis=1, keepdims=True))
+            h = h/h.sum(axis=1, keepdims=True)
+    return h
+
+def check(graph_def, layers):
+    graph = tf.Graph()
+    with graph.as_default():
+        tf.import_graph_def(graph_def, name="")
+    x = graph.get_tensor_by_name(options.inputOp + ":0")
+    y = graph.get_tensor_by_name(options.outputOp + ":0")
+
+    #random inputs distributed according to the input transformation stored in the graph
+    nInputs = layers[0][0].shape[0]
+    inputs = np.random.normal(size=(10000, nInputs)).astype(np.float32)
+    consts = dict((node.name, tensor_util.MakeNdarray(node.attr["value"].tensor)) for node in graph_def.node if node.name in ("offset", "scale"))
+    if "scale" in consts:  inputs /= np.where(consts["scale"] != 0, consts["scale"], 1)
+    if "offset" in consts: inputs += consts["offset"]
+
+    with tf.Session(graph=graph) as sess:
+        tfOut = sess.run(y, feed_dict={x: inputs})
+    nativeOut = evaluate(layers, inputs)
+
+    print("Maximum absolute difference to tensorflow: %g"%np.abs(tfOut[:,0] - nativeOut[:,0]).max())
+
+if __name__ == "__main__":
+    graph_def = loadGraphDef(options.input)
+    layers = buildNetwork(graph_def)
+    writeNetwork(layers, options.output)
+    print("Wrote %i layers (%s) to %s"%(len(layers), " -> ".join([str(layers[0][0].shape[0])] + [str(w.shape[1]) for w, b, act in layers]), options.output))
+
+    if options.calibInput:
+        cands = np.load(options.calibInput)
+        writeCalibration(layers, cands, options.calibOutput)
+        print("Wrote %i calibration candidates to %s"%(cands.shape[0], options.calibOutput))
+
+    if options.check:
+        check(graph_def, layers)
@@ -0,0 +1,88 @@
+#ifndef CANDIDATEKEYSET_H
+#define CANDIDATEKEYSET_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ *Open addressing hash set of top candidate keys (see TopObject::getKey) with linear probing.  Each key stores the position of the first top candidate inserted with this key.  Key 0 is reserved to mark empty slots.  The table is kept at most half full and its memory is reused after clear(), so it is intended to be filled once per event.
+ */
+class CandidateKeySet
+{
+private:
+    struct Slot
+    {
+        uint64_t key;
+        unsigned int iCand;
+    };
+
+    std::vector<Slot> slots_;
+    size_t size_;
+    unsigned int shift_;
+
+    size_t slotIndex(const uint64_t key) const
+    {
+        //fibonacci hashing, the high bits of the product are well mixed
+        return (key*0x9E3779B97F4A7C15ull) >> (64 - shift_);
+    }
+
+    void rehash(const unsigned int shift)
+    {
+        std::vector<Slot> oldSlots(size_t(1) << shift, Slot{0, 0});
+        oldSlots.swap(slots_);
+        shift_ = shift;
+        for(const Slot& slot : oldSlots)
+        {
+            if(slot.key == 0) continue;
+            size_t iSlot = slotIndex(slot.key);
+            while(slots_[iSlot].key != 0) iSlot = (iSlot + 1) & (slots_.size() - 1);
+            slots_[iSlot] = slot;
+        }
+    }
+
+public:
+    CandidateKeySet() : size_(0), shift_(0) {}
+
+    /** Number of keys in the set */
+    size_t size() const { return size_; }
+
+    /** Remove all keys, the memory is kept for the next event */
+    void clear()
+    {
+        if(size_ > 0) for(Slot& slot : slots_) slot.key = 0;
+        size_ = 0;
+    }
+
+    /** Get the position of the candidate stored with key, -1 if the key is not in the set (or is 0) */
+    int find(const uint64_t key) const
+    {
+        if(key == 0 || size_ == 0) return -1;
+        for(size_t iSlot = slotIndex(key); slots_[iSlot].key != 0; iSlot = (iSlot + 1) & (slots_.size() - 1))
+        {
+            if(slots_[iSlot].key == key) return slots_[iSlot].iCand;
+        }
+        return -1;
+    }
+
+    /** Check if key is in the set */
+    bool contains(const uint64_t key) const { return find(key) >= 0; }
+
+    /** Insert key with the position of its candidate, returns false (and leaves the set unchanged) if the key is already in the set or is 0 */
+    bool insert(const uint64_t key, const unsigned int iCand)
+    {
+        if(key == 0) return false;
+        if(2*(size_ + 1) > slots_.size()) rehash(shift_ < 4 ? 4 : shift_ + 1);
+
+        size_t iSlot = slotIndex(key);
+        for(; slots_[iSlot].key != 0; iSlot = (iSlot + 1) & (slots_.size() - 1))
+        {
+            if(slots_[iSlot].key == key) return false;
+        }
+        slots_[iSlot] = Slot{key, iCand};
+        ++size_;
+        return true;
+    }
+};
+
+#endif
@@ -112,7 +112,7 @@ public:
      *@param [in] var Name of the variable to retrieve
      *@return Value of the variable
      */
-    double getExtraVar(const std::string var) const;
+    double getExtraVar(const std::string& var) const;
     /** 
      *Retrieve list of jet index references
      *@return Vector containing jet reference indices 
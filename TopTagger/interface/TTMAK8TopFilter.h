@@ -8,6 +8,11 @@
 class TopTaggerResults;
 class Constituent;
 
+/**
+ *This module places all top candidates of the selected type directly into the final top list.
+ *
+ *@param type (int) Type of top candidate to select (see TopObject::Type), defaults to TopObject::MERGED_TOP.  TopObject::ANY (7) selects candidates of every type.
+ */
 class TTMAK8TopFilter : public TTModule
 {
 private:
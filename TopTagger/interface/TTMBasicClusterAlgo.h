@@ -23,6 +23,7 @@ class Constituent;
  *@param dRMaxDijet (float) The maximum allowed seperation if dR between the AK4 and AK8 jet and the dijet centroid for the dijet catagory.  
  *@param doMonojet (bool) Enable the fully merged top category clustering.
  *@param useDeepAK8 (bool) Use deepAK8 discriminator to identify boosted objects from AK8 jets instead of NSubjettiness.
+ *@param skipDuplicates (bool) Do not add candidates with the same type and constituents as an existing top candidate, e.g. one made by an earlier clustering module (Default false)
  *
  *See TTMConstituentReqs for more parameters
  */
@@ -45,7 +46,9 @@ private:
     //W-jet variables
     bool doMonoW_;
 
-    void fillTriplet(const Constituent* const, const Constituent* const, const Constituent* const, std::vector<TopObject>&);
+    bool skipDuplicates_;
+
+    void fillTriplet(const Constituent* const, const Constituent* const, const Constituent* const, TopTaggerResults&);
 
 public:
     void getParameters(const cfg::CfgDocument*, const std::string&);
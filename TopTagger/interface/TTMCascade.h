@@ -0,0 +1,46 @@
+#ifndef TTMCASCADE_H
+#define TTMCASCADE_H
+
+#include "TopTagger/TopTagger/interface/TTModule.h"
+#include "TopTagger/TopTagger/interface/TopObject.h"
+
+#include <string>
+#include <vector>
+
+/**
+ *This module is a cheap first stage for the expensive MVA modules.  A linear model of candidate level quantities which are already available is evaluated for every top candidate of the selected type, and candidates below the working point are flagged as rejected in the TopTaggerResults.  The MVA modules which follow do not evaluate rejected candidates, these instead receive the sentinel discriminator from this module.  The working point should be chosen with a very high signal efficiency.
+ *
+ *@param type (int) Type of top candidate to apply the prefilter to (see TopObject::Type), required
+ *@param var[] (string - array) Prefilter variables (at least one is required), the choices are "cand_pt", "cand_eta", "cand_m", "cand_dm" (|m - topMass|), "cand_dRMax", "cand_dThetaMin", "cand_dThetaMax" and "cand_nb" (number of b-tagged constituents)
+ *@param weight[] (float - array) Weight for each prefilter variable, required
+ *@param bias (float) Constant term of the linear model
+ *@param cut (float) Candidates with bias + sum(weight*var) below this value are rejected, required
+ *@param rejectedDisc (float) Sentinel discriminator given to rejected candidates (default -999.9)
+ *@param topMass (float) Reference mass for cand_dm (default 173.0)
+ *@param csvThreshold (float) Threshold on b-tag discriminator to be considered a b-jet for cand_nb
+ *@param bEtaCut (float) Requirment on |eta| for a constituent to be considered a b-jet for cand_nb
+ */
+class TTMCascade : public TTModule
+{
+private:
+    enum Variable {CAND_PT, CAND_ETA, CAND_M, CAND_DM, CAND_DRMAX, CAND_DTHETAMIN, CAND_DTHETAMAX, CAND_NB};
+
+    TopObject::Type type_;
+    std::vector<Variable> vars_;
+    std::vector<double> weights_;
+    double bias_;
+    double cut_;
+    double rejectedDisc_;
+    double topMass_;
+    double csvThreshold_;
+    double bEtaCut_;
+
+    double evaluate(const TopObject& topCand, const TopTaggerResults& ttResults) const;
+
+public:
+    void getParameters(const cfg::CfgDocument*, const std::string&);
+    void run(TopTaggerResults&);
+};
+REGISTER_TTMODULE(TTMCascade);
+
+#endif
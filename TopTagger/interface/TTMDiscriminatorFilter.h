@@ -14,7 +14,7 @@
  *@param discCut (float) Highest minimum discriminator threshold allowed (If discOffest is set > 1 and discSlope is positive then this serves as a basic discriminator threshold)
  *@param discOffset (float) Discriminator cut for zero pt top candidates 
  *@param discSlope (float) Pt dependent slopt for discriminator cut
- *@param type (int) Type of constituent to apply selection to (1 - monojet, 2 - dijet, 3 - trijet)
+ *@param type (int) Type of constituent to apply selection to (1 - monojet, 2 - dijet, 3 - trijet, see TopObject::Type), required.  TopObject::ANY (7) selects candidates of every type.
  *@param bdiscThreshold (float) Threshold on b-tag discriminator to be considered a b-jet.  
  *@param bEtaCut (float) Requirment on |eta| for a constituent to be considered a b-jet
  *@param maxNbInTop (int) The maximum number of constituent jets which can be b-tagged for the candidate to be a final top (set < 0 to disable)
@@ -30,6 +30,10 @@ private:
     int maxNbInTop_;
     TopObject::Type type_;
 
+    //Number of b-tagged constituents and selection mask of each candidate, reused between events
+    std::vector<int> nb_;
+    std::vector<char> pass_;
+
 public:
     void getParameters(const cfg::CfgDocument*, const std::string&);
     void run(TopTaggerResults&);
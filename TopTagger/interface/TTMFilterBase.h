@@ -3,6 +3,8 @@
 
 #include <set>
 #include <vector>
+#include <cstdint>
+#include <cstddef>
 
 class Constituent;
 
@@ -11,7 +13,57 @@ class Constituent;
  */
 class TTMFilterBase
 {
+private:
+    ///Per event overlap matrix, one row of bits per constituent marking which constituents an AK8 jet covers (rows of AK4 jets are empty), rows are filled on first use
+    const Constituent* overlapConstituents_;
+    size_t nOverlapConstituents_;
+    size_t nOverlapWords_;
+    double overlapDRMax_, overlapDRMaxAK8_;
+    mutable std::vector<uint64_t> overlapMatrix_;
+    mutable std::vector<char> overlapRowFilled_;
+
+    ///Index of a constituent in the overlap matrix, or nOverlapConstituents_ if it is not part of the current event
+    size_t overlapIndex(const Constituent* constituent) const;
+
+    ///Get the row of the overlap matrix for a constituent of the current event
+    const uint64_t* overlapRow(const size_t index) const;
+
 protected:
+    TTMFilterBase();
+
+    /**
+     *Checks if an AK8 jet covers another constituent, either through matching one of its subjets to the constituent or through matching the AK8 jet itself if it has fewer than 2 subjets
+     *
+     *@param constituentAK8 The AK8 jet
+     *@param constituent The constituent to match to the AK8 jet
+     *@param dRMatch The dR requirement used to select whether an AK4 jet matches a AK8 subjet
+     *@param dRMatchAK8 The dR requirement used to select whether an AK4 jet matches a AK8 jet without subjets
+     */
+    bool constituentCovers(const Constituent&, const Constituent&, const double, const double) const ;
+
+    /**
+     *Sets up the overlap matrix between the AK8 jets and all constituents in the event, each row is calculated the first time it is needed.  This must be called once per event by modules using the bitset overlap functions, the matrix is only used for constituents from the list it was built with.
+     *
+     *@param allConstituents List of all constituents
+     *@param dRMatch The dR requirement used to select whether an AK4 jet matches a AK8 subjet
+     *@param dRMatchAK8 The dR requirement used to select whether an AK4 jet matches a AK8 jet without subjets
+     */
+    void buildOverlapMatrix(const std::vector<Constituent>&, const double, const double);
+
+    /**
+     *Releases the overlap matrix of the current event, this must be called at the end of run() by modules which call buildOverlapMatrix
+     */
+    void clearOverlapMatrix();
+
+    /**
+     *Checks if an AK8 jet covers another constituent using the overlap matrix when both are part of the current event and the matrix was built with the same dR requirements, otherwise the match is calculated directly
+     *
+     *@param constituentAK8 The AK8 jet
+     *@param constituent The constituent to match to the AK8 jet
+     *@param dRMatch The dR requirement used to select whether an AK4 jet matches a AK8 subjet
+     *@param dRMatchAK8 The dR requirement used to select whether an AK4 jet matches a AK8 jet without subjets
+     */
+    bool constituentOverlaps(const Constituent&, const Constituent&, const double, const double) const ;
 
     /**
      *Checks if the constituents are used
@@ -30,6 +82,21 @@ protected:
      *@param dRMatch The dR requirement used to select whether an AK4 jet matches a AK8 subjet
      */
     void markConstituentsUsed(const std::vector<const Constituent *>&, const std::vector<Constituent>&, std::set<const Constituent*>&, const double, const double) const ;
+
+    /**
+     *Checks if the constituents are used, with the used constituents stored as a bitset indexed by position in the list of all constituents.  The overlap matrix must be built for this event.
+     *
+     *@param constituents List of constituents to check
+     *@param usedBits Bitset of all constituents already used in final reconstructed tops
+     */
+    bool constituentsAreUsed(const std::vector<const Constituent *>&, const std::vector<uint64_t>&) const ;
+    /**
+     *Marks constituents as being used in a final reconstructed top, with the used constituents stored as a bitset indexed by position in the list of all constituents.  The overlap matrix must be built for this event.
+     *
+     *@param constituents List of constituents to mark as used
+     *@param usedBits Bitset of all constituents already used in final reconstructed tops
+     */
+    void markConstituentsUsed(const std::vector<const Constituent *>&, std::vector<uint64_t>&) const ;
 };
 
 
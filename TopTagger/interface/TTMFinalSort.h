@@ -5,6 +5,10 @@
 #include "TopTagger/TopTagger/interface/TTMFilterBase.h"
 
 #include <string>
+#include <vector>
+#include <utility>
+
+class TopObject;
 
 class TopTaggerResults;
 
@@ -20,6 +24,9 @@ private:
     double mt_;
     std::string sortMethod_;
 
+    //Sort key and top of each final top, reused between events
+    std::vector<std::pair<double, TopObject*>> sortKeys_;
+
 public:
     void getParameters(const cfg::CfgDocument*, const std::string&);
     void run(TopTaggerResults&);
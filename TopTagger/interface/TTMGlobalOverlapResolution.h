@@ -0,0 +1,80 @@
+#ifndef TTMGLOBALOVERLAPRESOLUTION_H
+#define TTMGLOBALOVERLAPRESOLUTION_H
+
+#include "TopTagger/TopTagger/interface/TTModule.h"
+#include "TopTagger/TopTagger/interface/TTMFilterBase.h"
+#include "TopTagger/TopTagger/interface/TopObject.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class TopTaggerResults;
+
+/**
+ *This module is an alternative to TTMOverlapResolution.  Instead of accepting tops greedily in sorted order, it selects the set of non-overlapping tops which maximizes either the total discriminator or the number of tops.  The selection is solved exactly with a branch-and-bound search over the bitsets of conflicting tops, where a greedy clique cover of the remaining tops is used as the upper bound.  The search is started from the greedy solution and is stopped after a fixed number of search nodes per event, in which case the best solution found so far (at least as good as the greedy solution) is used.  Two tops conflict when they would overlap in TTMOverlapResolution, i.e. they share a constituent or an AK4 jet matched to an AK8 jet.  Tops which fail the eta requirement or overlap with constituents used by earlier modules are removed.
+ *
+ *@param maxTopEta (float) <b> Common context </b> Maximum |eta| of a top candidate to be considered a final reconstructed top
+ *@param dRMatch (float) <b> Common context </b> The dR requirement used to select whether an AK4 jet matches a AK8 subjet
+ *@param dRMatchAK8 (float) <b> Common context </b> The dR requirement used to select whether an AK4 jet matches a AK8 jet without subjets
+ *@param NConstituents (int) This parameter determines which tops to include in the overlap resolution process (see TopObject::Type), by default all tops are included.
+ *@param objective (string) The quantity to maximize, "mvaDisc" (total discriminator, default) or "nTops" (number of tops, for equal numbers of tops the greedy solution is kept).  For "mvaDisc" tops with a discriminator <= 0 can not increase the total, these are added after the search in order of discriminator where they do not overlap with the selected tops.
+ *@param nodeBudget (int) Maximum number of branch-and-bound nodes per event (default 10000)
+ *@param markUsed (bool) Mark the constituents of the selected tops as used (default true)
+ *
+ *The time spent and the search statistics are accumulated over all events and can be retrieved with getTiming().
+ */
+class TTMGlobalOverlapResolution : public TTModule, public TTMFilterBase
+{
+private:
+    enum Objective {MVADISC, NTOPS};
+
+    double maxTopEta_, dRMatch_, dRMatchAK8_;
+    TopObject::Type type_;
+    Objective objective_;
+    int nodeBudget_;
+    bool markUsed_;
+
+    //Search state, reused between events
+    int nCands_;
+    int nWords_;
+    std::vector<TopObject*> cands_;
+    std::vector<double> weights_;
+    std::vector<uint64_t> constituentMasks_;
+    std::vector<uint64_t> conflicts_;
+    std::vector<uint64_t> searchStack_;
+    std::vector<uint64_t> boundScratch_;
+    std::vector<int> selection_;
+    std::vector<int> bestSelection_;
+    double bestWeight_;
+    long nNodes_;
+    bool budgetExceeded_;
+
+    double upperBound(const uint64_t* available);
+    void search(int depth, double weight);
+    void solve();
+
+public:
+    ///Time spent and search statistics accumulated over all events
+    struct Timing
+    {
+        long nEvents;
+        long nBudgetExceeded;
+        long nNodesTotal;
+        double totalTime;   ///total time in seconds
+    };
+
+private:
+    Timing timing_;
+
+public:
+    TTMGlobalOverlapResolution();
+
+    void getParameters(const cfg::CfgDocument*, const std::string&);
+    void run(TopTaggerResults&);
+
+    const Timing& getTiming() const { return timing_; }
+};
+REGISTER_TTMODULE(TTMGlobalOverlapResolution);
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "TopTagger/TopTagger/interface/TTModule.h"
 
+#include <vector>
+
 class TopTaggerResults;
 
 /**
@@ -23,6 +25,11 @@ private:
     int maxNbInTop_;
     bool doTrijet_, doDijet_, doMonojet_;
 
+    //Columns of the trijet pair masses, number of b-tagged constituents and selection mask of each candidate, reused between events
+    std::vector<double> m12_, m23_, m13_;
+    std::vector<int> nb_;
+    std::vector<char> pass_;
+
 public:
     void getParameters(const cfg::CfgDocument*, const std::string&);
     void run(TopTaggerResults&);
@@ -9,7 +9,7 @@ class TTMLazyClusterAlgo : public TTModule
 {
 private:
     double lowWMassCut_, highWMassCut_, lowtMassCut_, hightMassCut_, minTopCandMass_, maxTopCandMass_, minJetPt_, dRMax_;
-    bool doMonojet_, doDijet_, doTrijet_;
+    bool doMonojet_, doDijet_, doTrijet_, skipDuplicates_;
 
 public:
     void getParameters(const cfg::CfgDocument*, const std::string&);
@@ -14,6 +14,7 @@ class Constituent;
  *@param doTrijet (bool) Enable the resolved top category clustering.
  *@param doMonojet (bool) Enable the fully merged top category clustering.
  *@param doMonoW (bool) Enable the fully merged W category clustering.
+ *@param skipDuplicates (bool) Do not add candidates with the same type and constituents as an existing top candidate, e.g. one made by an earlier clustering module (Default false)
  *
  *See TTMConstituentReqs for more parameters
  */
@@ -29,6 +30,8 @@ private:
     //W-jet variables
     bool doMonoW_;
 
+    bool skipDuplicates_;
+
 public:
     void getParameters(const cfg::CfgDocument*, const std::string&);
     void run(TopTaggerResults&);
@@ -0,0 +1,119 @@
+#ifndef TTMNATIVEDNN_H
+#define TTMNATIVEDNN_H
+
+#include "TopTagger/TopTagger/interface/TTModule.h"
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace ttUtility
+{
+    class MVAInputCalculator;
+    class MappedFile;
+}
+
+/**
+ *This module evaluates a fully connected (dense) neural network natively without any dependence on the tensorflow runtime.  The network weights are read from a simple binary file which can be produced from the frozen tensorflow graph with Tools/python/convertFrozenGraph.py.  All valid candidates in the event are evaluated together as one batch.  This module places top candidates which pass the requirements directly into the final top list.
+ *
+ *@param discCut (float) Highest minimum discriminator threshold allowed (If discOffest is set > 1 and discSlope is positive then this serves as a basic discriminator threshold)
+ *@param discOffset (float) Discriminator cut for zero pt top candidates
+ *@param discSlope (float) Pt dependent slopt for discriminator cut
+ *@param modelFile (string) Path to the converted model file
+ *@param NConstituents (int) Type of constituent to apply selection to (1 - monojet, 2 - dijet, 3 - trijet)
+ *@param csvThreshold (float) Threshold on b-tag discriminator to be considered a b-jet.
+ *@param bEtaCut (float) Requirment on |eta| for a constituent to be considered a b-jet
+ *@param maxNbInTop (int) The maximum number of constituent jets which can be b-tagged for the candidate to be a final top (set < 0 to disable)
+ *@param mvaVar[] (string - array) MVA variable input names
+ *@param saveInputs (bool) Debug option to save MVA inputs inside TopObject.  Defaults to false.
+ *@param precision (string) Arithmetic used for inference, "float" (default), "fp16" (weights and activations rounded to half precision) or "int8" (weights quantized per output node, activations quantized per candidate, integer accumulation)
+ *@param calibrationFile (string) For reduced precision, path to the calibration set shipped with the model (written by Tools/python/convertFrozenGraph.py).  The set is evaluated once with both the full and the reduced precision network when the module is configured and the mean discriminator shift at the working point is corrected for.  The shift and the fraction of calibration candidates passing the working point with each network can be retrieved with getCalibration().  If no file is given no correction is applied.
+ *@param calibrationWindow (float) Calibration candidates with a full precision discriminator within this distance of their threshold are used to calculate the discriminator shift at the working point.  Defaults to 0.05.
+ */
+class TTMNativeDNN : public TTModule
+{
+private:
+    enum Activation {LINEAR, RELU, SIGMOID, TANH, SOFTMAX};
+    enum Precision {FP32, FP16, INT8};
+
+    struct Layer
+    {
+        int nIn, nOut;
+        Activation activation;
+        //weights are stored row major as [nIn][nOut], the same convention used by tf.matmul, both point directly into the mapped model file
+        const float* weights;
+        const float* biases;
+        //reduced precision copies of the weights, the int8 weights are scaled per output node by weightScales
+        std::vector<uint16_t> weightsFP16;
+        std::vector<int8_t> weightsInt8;
+        std::vector<float> weightScales;
+    };
+
+    double discriminator_;
+    double discOffset_;
+    double discSlope_;
+    std::string modelFile_;
+    double csvThreshold_;
+    double bEtaCut_;
+    int maxNbInTop_;
+    int NConstituents_;
+    bool saveInputs_;
+    Precision precision_;
+    std::string calibrationFile_;
+    double calibrationWindow_;
+
+public:
+    ///Comparison of the full and reduced precision networks on the calibration set, fixed when the module is configured
+    struct Calibration
+    {
+        int nCand;
+        int nWorkingPoint;             ///candidates within calibrationWindow of the threshold used for the shift
+        double discShift;              ///correction added to the reduced precision discriminator (full - reduced)
+        double passFractionFull;       ///fraction of candidates passing the working point with the full precision network
+        double passFractionReduced;    ///the same for the reduced precision network before the correction
+        double passFractionCorrected;  ///the same for the reduced precision network after the correction
+    };
+
+private:
+    Calibration calibration_;
+
+    //Network definition, the full precision weights are read in place from the memory mapped model file
+    std::unique_ptr<ttUtility::MappedFile> modelData_;
+    std::vector<Layer> layers_;
+
+    //Scratch space for the network inputs and the layer outputs, reused between events
+    std::vector<float> inputBuf_;
+    std::vector<float> layerBuf_[2];
+    std::vector<int16_t> quantizedInput_;
+    std::vector<int32_t> accumulator_;
+    std::vector<float> expandedWeights_;
+
+    //Input variable names
+    std::vector<std::string> vars_;
+
+    //variable calclator
+    std::unique_ptr<ttUtility::MVAInputCalculator> varCalculator_;
+
+    double getThreshold(double pt) const;
+
+    void loadModel(const std::string& file);
+    void quantizeModel();
+    const float* evaluateNetwork(const float* input, int nRows, Precision precision);
+    void evaluateLayer(const Layer& layer, const float* in, float* out, int nRows) const;
+    void evaluateLayerFP16(const Layer& layer, const float* in, float* out, int nRows);
+    void evaluateLayerInt8(const Layer& layer, const float* in, float* out, int nRows);
+    void applyActivation(Activation activation, float* y, int nOut) const;
+    void calibrate(const std::string& file);
+
+public:
+    ~TTMNativeDNN();
+
+    void getParameters(const cfg::CfgDocument*, const std::string&);
+    void run(TopTaggerResults&);
+
+    const Calibration& getCalibration() const { return calibration_; }
+};
+REGISTER_TTMODULE(TTMNativeDNN);
+
+#endif
@@ -5,17 +5,24 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 
 #ifdef SHOTTOPTAGGER_DO_OPENCV
 #include "opencv/cv.h"
 #include "opencv/ml.h"
 #endif
 
+namespace ttUtility
+{
+    class MVAInputCalculator;
+}
+
 /**
- *This module implements an interface to the OpenCV randomforest package for filtering top candidates.  This module can either pass entries directly into the final top list, or filter entries out of the final top list if they do not pass the selection criteria. 
+ *This module implements an interface to the OpenCV randomforest package for filtering top candidates.  This module can either pass entries directly into the final top list, or filter entries out of the final top list if they do not pass the selection criteria.  All valid candidates in the event are evaluated with a single call to predict.
  *
  *@param discCut (float) Minimum threshold for the TMVA discriminator for the candidate to pass the selection
  *@param modelFile (string) Path to the model file
+ *@param NConstituents (int) Type of constituent to apply selection to (1 - monojet, 2 - dijet, 3 - trijet)
  *@param csvThreshold (float) Threshold on b-tag discriminator to be considered a b-jet.  
  *@param bEtaCut (float) Requirment on |eta| for a constituent to be considered a b-jet
  *@param maxNbInTop (int) The maximum number of constituent jets which can be b-tagged for the candidate to be a final *@param mvaVar[] (string - array) MVA variable input names
@@ -29,14 +36,23 @@ private:
     double csvThreshold_;
     double bEtaCut_;
     int maxNbInTop_;
+    int NConstituents_;
 
     //cv::Ptr is the opencv implementation of a smart pointer
     cv::Ptr<cv::ml::RTrees> treePtr_;
     std::vector<std::string> vars_;
 
+    //input data buffer with one row per candidate, reused between events
+    std::vector<float> data_;
+
+    //variable calclator
+    std::unique_ptr<ttUtility::MVAInputCalculator> varCalculator_;
+
 #endif
 
 public:
+    ~TTMOpenCVMVA();
+
     void getParameters(const cfg::CfgDocument*, const std::string&);
     void run(TopTaggerResults&);
 
@@ -6,7 +6,8 @@
 #include "TopTagger/TopTagger/interface/TopObject.h"
 
 #include <string>
-#include <functional>
+#include <vector>
+#include <cstdint>
 
 class TopTaggerResults;
 
@@ -19,6 +20,8 @@ class TopTaggerResults;
  *@param cvsThreshold (float) Minimum cut value on the CSV discriminator for an AK4 jet to be considered a b-tagged jet
  *@param NConstituents (int) This parameter determines which tops to include in the overlap resolution process. The options include "-1" for all tops, or 1, 2, or 3, for monojet, dijet, or trijet categories respectively.  
  *@param sortMethod (string) The initial sorting order used to prioritize one top over another when resolving overlapping.  The options include "topMass", "topPt", "mvaDisc", "mvaDiscWithb", and "none".  
+ *
+ *The time spent is accumulated over all events and can be retrieved with getTiming() for comparison with TTMGlobalOverlapResolution.
  */
 class TTMOverlapResolution : public TTModule, public TTMFilterBase
 {
@@ -26,12 +29,44 @@ private:
     double mt_, maxTopEta_, dRMatch_, dRMatchAK8_, cvsThreshold_;
     TopObject::Type type_;
     std::string sortMethod_;
-    std::function<bool (const TopObject* t1, const TopObject* t2)> sortFunc_;
-    bool doSort_, markUsed_;
+    bool markUsed_;
+
+    enum SortType {NONE, TOPMASS, TOPPT, MVADISC, MVADISCWITHB};
+    SortType sortType_;
+
+    //Figure of merit for sorting, calculated once per top
+    struct SortKey
+    {
+        double value;
+        int nb;
+        TopObject* top;
+    };
+    std::vector<SortKey> sortKeys_;
+
+    //Bitset of the used constituents, reused between events
+    std::vector<uint64_t> usedBits_;
+
+    double sortMass(const TopObject& top) const;
+    void sortTops(const TopTaggerResults& ttResults, std::vector<TopObject*>& tops);
 
 public:
+    ///Time spent accumulated over all events
+    struct Timing
+    {
+        long nEvents;
+        double totalTime;   ///total time in seconds
+    };
+
+private:
+    Timing timing_;
+
+public:
+    TTMOverlapResolution();
+
     void getParameters(const cfg::CfgDocument*, const std::string&);
     void run(TopTaggerResults&);
+
+    const Timing& getTiming() const { return timing_; }
 };
 REGISTER_TTMODULE(TTMOverlapResolution);
 
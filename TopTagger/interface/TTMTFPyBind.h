@@ -19,7 +19,7 @@ namespace ttUtility
 }
 
 /**
- *This module implements an interface to Tensorflow through python for filtering top candidates.  This module places top candidates which pass the requirements directly into the final top list.
+ *This module implements an interface to Tensorflow through python for filtering top candidates.  All valid candidates in the event are passed to python as a single numpy array and evaluated with one session run.  This module places top candidates which pass the requirements directly into the final top list.
  *
  *@param discCut (float) Highest minimum discriminator threshold allowed (If discOffest is set > 1 and discSlope is positive then this serves as a basic discriminator threshold)
  *@param discOffset (float) Discriminator cut for zero pt top candidates 
@@ -50,10 +50,17 @@ private:
     //Input variable names 
     std::vector<std::string> vars_;
 
-    PyObject *pModule_, *pMain_;
+    //the embedded script runs in a namespace private to this instance
+    PyObject *pModule_;
     PyObject *pGlobal_;
-    PyObject *nparray_;
     PyObject *inputs_;
+
+    //the interpreter is only finalized if this module created it, the thread state is saved when the GIL is released after creating it
+    bool ownInterpreter_;
+    PyThreadState *threadState_;
+
+    //Input matrix with one row per candidate, filled without holding the GIL
+    std::vector<float> inputBuf_;
     
     //variable calclator
     std::unique_ptr<ttUtility::MVAInputCalculator> varCalculator_;
@@ -64,6 +71,7 @@ private:
 #endif
 
 public:
+    TTMTFPyBind();
     ~TTMTFPyBind();
 
     void getParameters(const cfg::CfgDocument*, const std::string&);
@@ -10,21 +10,25 @@
 #ifdef SHOTTOPTAGGER_DO_TMVA
 #include "TMVA/Tools.h"
 #include "TMVA/Reader.h"
+#include "TMVA/MethodBase.h"
 #endif
 
+class TopObject;
+
 namespace ttUtility
 {
     class MVAInputCalculator;
 }
 
 /**
- *This module implements an interface to TMVA for filtering top candidates.  This module can either pass entries directly into the final top list, or filter entries out of the final top list if they do not pass the selection criterion. 
+ *This module implements an interface to TMVA for filtering top candidates.  This module can either pass entries directly into the final top list, or filter entries out of the final top list if they do not pass the selection criterion.  The input variables for all candidates are calculated first and then evaluated in one batch, optionally split across several threads each with their own TMVA::Reader. 
  *
  *@param discCut (float) Minimum threshold for the TMVA discriminator for te candidate to pass the selection
  *@param modelFile (string) Path to the model file
  *@param modelName (string) Name of the model
  *@param NConstituents (int) What type of constituents to apply selection too (1 - monojet, 2 - dijet, 3 - trijet)
  *@param filter (bool) Filter failing candidates from the final top list instead of adding passing candidates to the final tops list
+ *@param NThreads (int) Number of threads to use for evaluating the candidates in each event (default 1)
  *@param mvaVar[] (string - array) MVA variable input names
  */
 class TTMTMVA : public TTModule
@@ -37,17 +41,26 @@ private:
     std::vector<std::string> varsTMVA_;
     int NConstituents_;
     bool filter_;
+    int nThreads_;
+
+    //TMVA model variables, one reader (and its input variables) per thread
+    std::vector<std::unique_ptr<TMVA::Reader>> readers_;
+    std::vector<TMVA::MethodBase*> methods_;
+    std::vector<std::vector<float>> varMaps_;
 
-    //TMVA model variables 
-    std::unique_ptr<TMVA::Reader> reader_;
-    std::vector<float> varMap_;
+    //input variables for all candidates in the event with one row per candidate
+    std::vector<float> data_;
 
     //variable calclator
     std::unique_ptr<ttUtility::MVAInputCalculator> varCalculator_; 
 
+    void evaluate(const unsigned int iReader, const std::vector<TopObject*>& cands, const unsigned int first, const unsigned int last);
+
 #endif
 
 public:
+    ~TTMTMVA();
+
     void getParameters(const cfg::CfgDocument*, const std::string&);
     void run(TopTaggerResults&);
 
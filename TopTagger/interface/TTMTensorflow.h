@@ -61,8 +61,6 @@ private:
     std::vector<TF_Output>     outputs_;
     std::vector<TF_Operation*> targets_;
 
-    TF_Buffer* read_file(const std::string& file);
-
     //variable calclator                                                                                                                                                                                                                     
     std::unique_ptr<ttUtility::MVAInputCalculator> varCalculator_;
 #endif
@@ -26,6 +26,7 @@ namespace ttUtility
  *@param csvThreshold (float) Threshold on b-tag discriminator to be considered a b-jet.  
  *@param bEtaCut (float) Requirment on |eta| for a constituent to be considered a b-jet
  *@param maxNbInTop (int) The maximum number of constituent jets which can be b-tagged for the candidate to be a final *@param mvaVar[] (string - array) MVA variable input names
+ *@param earlyExit (bool) Evaluate the trees natively, largest leaf range first, and reject a candidate as soon as the remaining trees can no longer bring its score above discCut.  Candidates which are not rejected are evaluated by xgboost as usual, rejected candidates get the upper bound on their score computed from the trees (which is below discCut) as discriminator.  Defaults to false.
  */
 class TTMXGBoost : public TTModule
 {
@@ -38,6 +39,7 @@ private:
     int NConstituents_;
     int maxNbInTop_;
     int nCores_;
+    bool earlyExit_;
 
     //XGBoost booster pointer
     BoosterHandle h_booster;
@@ -51,6 +53,37 @@ private:
     //variable calclator
     std::unique_ptr<ttUtility::MVAInputCalculator> varCalculator_; 
 
+    //Native copy of the trees used for the early exit
+    struct TreeNode
+    {
+        //feature < 0 for leaves
+        int feature;
+        float threshold;
+        int yes, no, missing;
+        float leaf;
+    };
+
+    struct Tree
+    {
+        std::vector<TreeNode> nodes;
+        float minLeaf, maxLeaf;
+    };
+
+    //trees sorted by decreasing leaf range and the sum of the largest leaves of trees i to the end
+    std::vector<Tree> trees_;
+    std::vector<double> remainingMax_;
+    //margin = marginOffset_ + sum of leaves, the discriminator is sigmoid(margin) for logistic objectives and the margin otherwise
+    double marginOffset_;
+    bool logistic_;
+    double marginThreshold_;
+    double marginTolerance_;
+
+    float predict(const float* data, int optionMask);
+    void loadTrees();
+    float evaluateTree(const Tree& tree, const float* data) const;
+    float maxReachableLeaf(const Tree& tree, int iNode, const float* data) const;
+    bool rejectEarly(const float* data, double& discUpperBound) const;
+
 #endif
 
 public:
@@ -5,6 +5,7 @@
 #include <map>
 #include <set>
 #include <memory>
+#include <cstdint>
 
 #include "TLorentzVector.h"
 
@@ -72,6 +73,8 @@ public:
     int getNConstituents() const { return constituents_.size(); }
     /// The number of b-tagged constituents based on the b-tagging discriminator cut and the jet eta
     int getNBConstituents(double cvsCut, double etaCut = 2.4) const;
+    /// Canonical key identifying the candidate by type and constituents, where constituents must be the vector the constituents point into.  The positions of the constituents (+1) are sorted and packed into 16 bits each (bits 0-47) and the type is stored in bits 56-63.  Returns 0 (no key) for more than 3 constituents or constituents not in the vector.
+    uint64_t getKey(const std::vector<Constituent>& constituents) const;
 
     /// Returns the list of all possible generator level tops which could be a match to the TopObject.  This requires that generator level information is passed to the top tagger.  
     const decltype(genMatchPossibilities_)& getGenTopMatches() const { return genMatchPossibilities_; }
@@ -72,12 +72,13 @@ public:
 
     /**
      *Set the configuration file to use to configure the TopTagger object.
-     *This function expects the path to an external configuration file.
+     *This function expects the path to an external configuration file, either 
+     *in text format or a binary snapshot made with CfgDocument::snapshot (see makeCfgSnapshot).
      */
     void setCfgFile(const std::string&);
     /**
      *Set the configuration file directly from a string.
-     *This function expects the configuration in the format of a raw string.
+     *This function expects the configuration in the format of a raw string (or the contents of a snapshot).
      */
     void setCfgFileDirect(const std::string&);
 
@@ -99,6 +100,12 @@ public:
      */
     const TopTaggerResults& getResults() const;
 
+    /**
+     *Gets the modules run by the tagger in run order, e.g. to retrieve statistics 
+     *accumulated by a module such as TTMOverlapResolution::getTiming().
+     */
+    const std::vector<std::unique_ptr<TTModule>>& getModules() const { return topTaggerModules_; }
+
 };
 
 #endif
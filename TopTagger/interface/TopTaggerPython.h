@@ -195,7 +195,134 @@ namespace ttPython
         }    
     };
 
+    /**
+     *Non-owning view of a contiguous range of elements with the vector-like interface used by the ttUtilities classes.  This is used to pass the inputs of one event out of the flat (columnar) arrays of a chunk of events without copying.  The memory viewed must stay in scope until the span is destroyed.
+     */
+    template<typename T>
+    class Span
+    {
+    private:
+        const T* begin_;
+        unsigned int len_;
+
+    public:
+        Span() : begin_(nullptr), len_(0) {}
+        Span(const T* begin, unsigned int len) : begin_(begin), len_(len) {}
+
+        unsigned int size() const
+        {
+            return len_;
+        }
+
+        const T& operator[](unsigned int i) const 
+        {
+            return begin_[i]; 
+        }
+
+        const T* begin() const 
+        {
+            return begin_; 
+        }
+
+        const T* end() const 
+        {
+            return begin_ + len_; 
+        }
+    };
+
 #ifdef DOPYCAPIBIND
+    ///numpy type number of the C++ type T
+    template<typename T> int npyType();
+    template<> inline int npyType<float>()      { return NPY_FLOAT32; }
+    template<> inline int npyType<int>()        { return NPY_INT32; }
+    template<> inline int npyType<bool>()       { return NPY_BOOL; }
+    template<> inline int npyType<npy_int64>()  { return NPY_INT64; }
+
+    /**
+     *Wrapper holding a contiguous 1D numpy array of type T made from any python array-like object (numpy array, list, flat content of an awkward array, ...) for use with the chunked (columnar) interface.  The input is only copied (and cast) if it is not already a contiguous array of type T.  This holds a reference to the array, so it must be destroyed while the GIL is held.
+     */
+    template<typename T>
+    class Py_array_wrapper
+    {
+    private:
+        PyArrayObject* array_;
+
+    public:
+        Py_array_wrapper() : array_(nullptr) {}
+
+        Py_array_wrapper(const Py_array_wrapper&) = delete;
+        Py_array_wrapper& operator=(const Py_array_wrapper&) = delete;
+
+        ~Py_array_wrapper()
+        {
+            Py_XDECREF(array_);
+        }
+
+        ///Wrap the object pObj, None leaves the wrapper empty.  Returns false with the python error set if pObj can not be converted to a 1D array of type T
+        bool set(PyObject* pObj)
+        {
+            Py_XDECREF(array_);
+            array_ = nullptr;
+
+            if(!pObj || pObj == Py_None) return true;
+
+            array_ = reinterpret_cast<PyArrayObject*>(PyArray_FROM_OTF(pObj, npyType<T>(), NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST));
+            if(!array_) return false;
+
+            if(PyArray_NDIM(array_) != 1)
+            {
+                Py_DECREF(array_);
+                array_ = nullptr;
+                PyErr_SetString(PyExc_ValueError, "Chunked top tagger inputs must be 1D arrays");
+                return false;
+            }
+
+            return true;
+        }
+
+        bool valid() const
+        {
+            return array_ != nullptr;
+        }
+
+        npy_intp size() const
+        {
+            return array_ ? PyArray_SIZE(array_) : 0;
+        }
+
+        const T* data() const
+        {
+            return array_ ? reinterpret_cast<const T*>(PyArray_DATA(array_)) : nullptr;
+        }
+
+        ///View of the elements [first, first + len)
+        Span<T> span(npy_int64 first, npy_int64 len) const
+        {
+            if(!array_) return Span<T>();
+            return Span<T>(data() + first, static_cast<unsigned int>(len));
+        }
+    };
+
+    /**
+     *Release the GIL for the lifetime of this object so other python threads can run, the GIL is taken back when it goes out of scope (also when an exception is thrown).  Only pure C++ code which does not touch python objects may run while it exists.
+     */
+    class GILRelease
+    {
+    private:
+        PyThreadState* threadState_;
+
+    public:
+        GILRelease() : threadState_(PyEval_SaveThread()) {}
+
+        GILRelease(const GILRelease&) = delete;
+        GILRelease& operator=(const GILRelease&) = delete;
+
+        ~GILRelease()
+        {
+            PyEval_RestoreThread(threadState_);
+        }
+    };
+
     template<>
     void Py_buffer_wrapper<TLorentzVector>::translatePyList(PyObject* pList)
     {
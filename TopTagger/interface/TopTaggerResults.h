@@ -3,17 +3,75 @@
 
 #include "TopTagger/TopTagger/interface/TopObject.h"
 #include "TopTagger/TopTagger/interface/Constituent.h"
+#include "TopTagger/TopTagger/interface/CandidateKeySet.h"
+#include "TopTagger/CfgParser/include/TTException.h"
+
+#include "TLorentzVector.h"
+#include "Math/VectorUtil.h"
 
 #include <vector>
+#include <deque>
 #include <map>
+#include <array>
 #include <set>
+#include <string>
 #include <memory>
+#include <utility>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
 
 /**
  *This is a holder class which holds the final collection of top objects, along with the constituents used to construct them and any intermediate information used by modules.  This serves both as the user interface for the results and a container to pass between modules.
  */
 class TopTaggerResults
 {
+public:
+    ///Kinematics of a pair of constituents
+    struct ConstituentPair
+    {
+        ///DeltaR between the two constituents
+        double dR;
+        ///Invariant mass of the pair
+        double m;
+        ///Sum of the 4-vectors of the pair
+        TLorentzVector p;
+    };
+
+    ///One variable of the MVA input store, the values are indexed by the position of the candidate in the top candidate vector and are only valid where filled is set
+    struct MVAInputColumn
+    {
+        std::vector<float> values;
+        std::vector<char> filled;
+    };
+    ///Key of the MVA input store, the type of candidate the variable was calculated for and the variable name (the same name can be defined differently for different candidate types)
+    typedef std::pair<TopObject::Type, std::string> MVAInputKey;
+
+    ///Columnar copy of the top candidate properties used by the filter modules, row i belongs to the i-th top candidate
+    struct CandidateTable
+    {
+        ///Maximum number of constituent positions stored per candidate
+        enum {MAXCONSTITUENTS = 3};
+
+        std::vector<double> m;
+        std::vector<double> pt;
+        ///eta and phi are only filled when requested from getCandidateTable as they are comparatively expensive to calculate
+        std::vector<double> eta;
+        std::vector<double> phi;
+        std::vector<double> disc;
+        std::vector<TopObject::Type> type;
+        std::vector<int> nConstituents;
+        ///Positions of the constituents in the constituent vector, MAXCONSTITUENTS entries per candidate padded with -1
+        std::vector<int> constituents;
+
+        size_t size() const { return m.size(); }
+        void clear()
+        {
+            m.clear(); pt.clear(); eta.clear(); phi.clear(); disc.clear();
+            type.clear(); nConstituents.clear(); constituents.clear();
+        }
+    };
+
 private:
     ///List of input objects which can be included in a resolved top
     ///Will never be modified or changed by modules 
@@ -29,11 +87,142 @@ private:
     std::vector<TopObject*> tops_;
 
     ///Final tops sorted by type
-    std::map<TopObject::Type, std::vector<TopObject*>> topsByType_;
+    std::array<std::vector<TopObject*>, TopObject::NTYPE> topsByType_;
 
     ///The remaining system container
     TopObject rsys_;
 
+    ///Flags top candidates rejected by a prefilter module (indexed like topCandidates_), the MVA modules do not evaluate these candidates
+    std::vector<bool> rejectedCandidates_;
+
+    ///Lazily filled cache of pair kinematics, stored as a lower triangular matrix indexed by the positions of the constituents in constituents_
+    mutable std::vector<ConstituentPair> constituentPairs_;
+    mutable std::vector<char> constituentPairFilled_;
+
+    ///Columnar copy of topCandidates_, rows are added for new candidates when the table is requested
+    mutable CandidateTable candidateTable_;
+
+    ///Positions of the top candidates split by type, and of all top candidates, filled together with candidateTable_
+    mutable std::array<std::vector<unsigned int>, TopObject::NTYPE> candidatesByType_;
+    mutable std::vector<unsigned int> allCandidates_;
+
+    ///Keys of the top candidates (indexed like topCandidates_) and the set of keys mapped to the position of the first candidate with each key, filled when keys are first requested
+    mutable std::vector<uint64_t> candidateKeys_;
+    mutable CandidateKeySet candidateKeySet_;
+
+    ///b-tag flags of the constituents for one pair of cuts, one bit per constituent
+    struct BTagBits
+    {
+        double cvsCut;
+        double etaCut;
+        std::vector<uint64_t> bits;
+    };
+
+    ///Per event orderings and type lists of the constituents (filled on first use) and b-tag flags for each pair of cuts requested (a deque so that references handed out stay valid when flags for new cuts are added)
+    mutable bool constituentOrderFilled_;
+    mutable std::vector<unsigned int> constituentPtOrder_;
+    mutable std::vector<unsigned int> constituentBTagOrder_;
+    mutable std::map<Constituent::ConstituentType, std::vector<unsigned int>> constituentsByType_;
+    mutable std::deque<BTagBits> bTagBits_;
+
+    ///MVA input variables shared between modules, keyed by candidate type and variable name
+    std::map<MVAInputKey, MVAInputColumn> mvaInputs_;
+
+    ///Reset all information derived from the constituents
+    void resetConstituentCaches()
+    {
+        constituentPairs_.clear();
+        constituentPairFilled_.clear();
+        candidateTable_.clear();
+        for(auto& partition : candidatesByType_) partition.clear();
+        allCandidates_.clear();
+        candidateKeys_.clear();
+        candidateKeySet_.clear();
+        constituentOrderFilled_ = false;
+        constituentPtOrder_.clear();
+        constituentBTagOrder_.clear();
+        constituentsByType_.clear();
+        bTagBits_.clear();
+    }
+
+    ///Fill the orderings and type lists of the constituents
+    void fillConstituentOrder() const
+    {
+        if(constituentOrderFilled_) return;
+
+        const std::vector<Constituent>& constituents = *constituents_;
+        constituentPtOrder_.resize(constituents.size());
+        for(unsigned int iConst = 0; iConst < constituents.size(); ++iConst)
+        {
+            constituentPtOrder_[iConst] = iConst;
+            constituentsByType_[constituents[iConst].getType()].push_back(iConst);
+        }
+        constituentBTagOrder_ = constituentPtOrder_;
+
+        std::stable_sort(constituentPtOrder_.begin(), constituentPtOrder_.end(), [&constituents](const unsigned int i1, const unsigned int i2){ return constituents[i1].p().Pt() > constituents[i2].p().Pt(); });
+        std::stable_sort(constituentBTagOrder_.begin(), constituentBTagOrder_.end(), [&constituents](const unsigned int i1, const unsigned int i2){ return constituents[i1].getBTagDisc() > constituents[i2].getBTagDisc(); });
+
+        constituentOrderFilled_ = true;
+    }
+
+    ///Add the rows of the candidate table and the type partitions for candidates created since the last call
+    void updateCandidateRows() const
+    {
+        //candidates are only ever appended, the table is rebuilt if this is not the case
+        if(candidateTable_.size() > topCandidates_.size())
+        {
+            candidateTable_.clear();
+            for(auto& partition : candidatesByType_) partition.clear();
+            allCandidates_.clear();
+        }
+
+        const size_t nRows = topCandidates_.size();
+        const size_t nOld = candidateTable_.size();
+        if(nRows > nOld)
+        {
+            candidateTable_.m.resize(nRows);
+            candidateTable_.pt.resize(nRows);
+            candidateTable_.type.resize(nRows);
+            candidateTable_.nConstituents.resize(nRows);
+            candidateTable_.constituents.resize(nRows*CandidateTable::MAXCONSTITUENTS);
+        }
+        for(size_t iCand = nOld; iCand < nRows; ++iCand)
+        {
+            const TopObject& topCand = topCandidates_[iCand];
+            const TLorentzVector& p = topCand.p();
+            candidateTable_.m[iCand] = p.M();
+            candidateTable_.pt[iCand] = p.Pt();
+            candidateTable_.type[iCand] = topCand.getType();
+            if(topCand.getType() < TopObject::NTYPE) candidatesByType_[topCand.getType()].push_back(iCand);
+            allCandidates_.push_back(iCand);
+
+            const std::vector<Constituent const *>& jets = topCand.getConstituents();
+            candidateTable_.nConstituents[iCand] = jets.size();
+            for(unsigned int iJet = 0; iJet < CandidateTable::MAXCONSTITUENTS; ++iJet)
+            {
+                const size_t iConst = (iJet < jets.size()) ? jets[iJet] - constituents_->data() : constituents_->size();
+                candidateTable_.constituents[iCand*CandidateTable::MAXCONSTITUENTS + iJet] = (iConst < constituents_->size()) ? static_cast<int>(iConst) : -1;
+            }
+        }
+    }
+
+    ///Add the keys of the candidates created since the last call
+    void updateCandidateKeys() const
+    {
+        //candidates are only ever appended, the keys are recalculated if this is not the case
+        if(candidateKeys_.size() > topCandidates_.size())
+        {
+            candidateKeys_.clear();
+            candidateKeySet_.clear();
+        }
+
+        for(size_t iCand = candidateKeys_.size(); iCand < topCandidates_.size(); ++iCand)
+        {
+            candidateKeys_.push_back(topCandidates_[iCand].getKey(*constituents_));
+            candidateKeySet_.insert(candidateKeys_.back(), iCand);
+        }
+    }
+
 public:
     
     /**
@@ -41,9 +230,9 @@ public:
      *the top tagger results are in scope.  This copy is totally internal and is
      *managed by the shared pointer.  
      */
-    TopTaggerResults(const std::vector<Constituent>& constituents) : constituents_(new std::vector<Constituent>(constituents)) {}
+    TopTaggerResults(const std::vector<Constituent>& constituents) : constituents_(new std::vector<Constituent>(constituents)), constituentOrderFilled_(false) {}
 
-    TopTaggerResults(std::vector<Constituent>&& constituents) : constituents_(new std::vector<Constituent>(std::move(constituents))) {}
+    TopTaggerResults(std::vector<Constituent>&& constituents) : constituents_(new std::vector<Constituent>(std::move(constituents))), constituentOrderFilled_(false) {}
 
     ~TopTaggerResults() {}
 
@@ -53,6 +242,7 @@ public:
     {
         //Again a copy is made to ensure this vector remains in scope
         constituents_.reset(new std::vector<Constituent>(constituents));
+        resetConstituentCaches();
     }
 
     /** Set/reset the internal copy of the constituents vector */
@@ -60,6 +250,7 @@ public:
     {
         //Again a copy is made to ensure this vector remains in scope
         constituents_.reset(new std::vector<Constituent>(constituents));
+        resetConstituentCaches();
     }
 
     //non-const getters (for modules)
@@ -68,6 +259,8 @@ public:
     decltype(tops_)& getTops() { return tops_; }
     decltype(rsys_)& getRsys() { return rsys_; }
     decltype(topsByType_)& getTopsByType() { return topsByType_; }
+    decltype(mvaInputs_)& getMVAInputs() { return mvaInputs_; }
+    decltype(rejectedCandidates_)& getRejectedCandidates() { return rejectedCandidates_; }
     
     //const getters for public consumption
     /** Get the internal vector of constituents */
@@ -78,10 +271,165 @@ public:
     const decltype(topCandidates_)& getTopCandidates() const { return topCandidates_; }
     /** Get the vector of final reconstructed tops */
     const decltype(tops_)& getTops() const { return tops_; }
-    /** Get a map of final top objects split by type */
+    /** Get the final top objects split by type, indexed by TopObject::Type */
     const decltype(topsByType_)& getTopsByType() const { return topsByType_; }
     /** Get the remaining system used for MT2 calculations in the case when there is only one reconstructed top */
     const decltype(rsys_)& getRsys() const { return rsys_; }
+    /** Get the MVA input variables calculated by the modules, indexed by candidate type and variable name and then by position in the top candidate vector */
+    const decltype(mvaInputs_)& getMVAInputs() const { return mvaInputs_; }
+    /** Get the kinematics of a pair of constituents given by their positions in the constituent vector, each pair is calculated at most once per event */
+    const ConstituentPair& getConstituentPair(unsigned int i, unsigned int j) const
+    {
+        const unsigned int nConstituents = constituents_->size();
+        if(i >= nConstituents || j >= nConstituents)
+        {
+            THROW_TTEXCEPTION("Constituent index out of range");
+        }
+
+        if(i < j) std::swap(i, j);
+        if(constituentPairs_.empty())
+        {
+            constituentPairs_.resize(nConstituents*(nConstituents + 1)/2);
+            constituentPairFilled_.resize(nConstituents*(nConstituents + 1)/2, false);
+        }
+
+        const unsigned int iPair = i*(i + 1)/2 + j;
+        ConstituentPair& pair = constituentPairs_[iPair];
+        if(!constituentPairFilled_[iPair])
+        {
+            const TLorentzVector& p1 = (*constituents_)[j].p();
+            const TLorentzVector& p2 = (*constituents_)[i].p();
+            pair.p = p1 + p2;
+            pair.dR = ROOT::Math::VectorUtil::DeltaR(p1, p2);
+            pair.m = pair.p.M();
+            constituentPairFilled_[iPair] = true;
+        }
+        return pair;
+    }
+    /** Get the kinematics of a pair of constituents, both must point into the constituent vector */
+    const ConstituentPair& getConstituentPair(const Constituent& c1, const Constituent& c2) const
+    {
+        return getConstituentPair(&c1 - constituents_->data(), &c2 - constituents_->data());
+    }
+    /** Get the columnar candidate table, rows are added for candidates created since the last call and the discriminators of all rows are updated.  The eta and phi columns are only filled if withAngles is true. */
+    const CandidateTable& getCandidateTable(const bool withAngles = false) const
+    {
+        updateCandidateRows();
+        const size_t nRows = topCandidates_.size();
+
+        if(withAngles)
+        {
+            for(size_t iCand = candidateTable_.eta.size(); iCand < nRows; ++iCand)
+            {
+                candidateTable_.eta.push_back(topCandidates_[iCand].p().Eta());
+                candidateTable_.phi.push_back(topCandidates_[iCand].p().Phi());
+            }
+        }
+
+        //the discriminators are set by the MVA modules after the candidates are created
+        candidateTable_.disc.resize(nRows);
+        for(size_t iCand = 0; iCand < nRows; ++iCand) candidateTable_.disc[iCand] = topCandidates_[iCand].getDiscriminator();
+
+        return candidateTable_;
+    }
+    /** Get the positions of the top candidates of a given type in the top candidate vector (in increasing order), TopObject::ANY returns all candidates */
+    const std::vector<unsigned int>& getCandidatesOfType(const TopObject::Type type) const
+    {
+        updateCandidateRows();
+        if(type == TopObject::ANY) return allCandidates_;
+        if(type >= TopObject::NTYPE)
+        {
+            THROW_TTEXCEPTION("Invalid top candidate type");
+        }
+        return candidatesByType_[type];
+    }
+    /** Get the canonical key of a top object (see TopObject::getKey), 0 if the top object has no key */
+    uint64_t getCandidateKey(const TopObject& top) const { return top.getKey(*constituents_); }
+    /** Get the keys of all top candidates, indexed by position in the top candidate vector.  The keys are calculated once per candidate on first use. */
+    const std::vector<uint64_t>& getCandidateKeys() const
+    {
+        updateCandidateKeys();
+        return candidateKeys_;
+    }
+    /** Get the position of the first top candidate with the given key, -1 if there is no such candidate */
+    int findTopCandidate(const uint64_t key) const
+    {
+        updateCandidateKeys();
+        return candidateKeySet_.find(key);
+    }
+    /** Check if a top candidate with the same type and constituents as top already exists, always false for top objects without a key */
+    bool hasTopCandidate(const TopObject& top) const { return findTopCandidate(getCandidateKey(top)) >= 0; }
+    /** Count the b-tagged constituents of every top candidate (indexed like the candidate table), with the same definition as TopObject::getNBConstituents */
+    void countBConstituents(const double cvsCut, const double etaCut, std::vector<int>& nb) const
+    {
+        const CandidateTable& table = getCandidateTable();
+        const std::vector<uint64_t>& isB = getBTagBits(cvsCut, etaCut);
+
+        nb.assign(table.size(), 0);
+        for(size_t iCand = 0; iCand < table.size(); ++iCand)
+        {
+            const int* iConst = &table.constituents[iCand*CandidateTable::MAXCONSTITUENTS];
+            bool inTable = table.nConstituents[iCand] <= CandidateTable::MAXCONSTITUENTS;
+            for(int iJet = 0; iJet < table.nConstituents[iCand] && inTable; ++iJet) inTable = iConst[iJet] >= 0;
+
+            if(inTable) for(int iJet = 0; iJet < table.nConstituents[iCand]; ++iJet) nb[iCand] += (isB[iConst[iJet] >> 6] >> (iConst[iJet] & 63)) & 1;
+            else        nb[iCand] = topCandidates_[iCand].getNBConstituents(cvsCut, etaCut);
+        }
+    }
+    /** Get the positions of the constituents in order of decreasing pt */
+    const std::vector<unsigned int>& getConstituentPtOrder() const
+    {
+        fillConstituentOrder();
+        return constituentPtOrder_;
+    }
+    /** Get the positions of the constituents in order of decreasing b-tag discriminator, constituents with equal discriminators keep their relative order */
+    const std::vector<unsigned int>& getConstituentBTagOrder() const
+    {
+        fillConstituentOrder();
+        return constituentBTagOrder_;
+    }
+    /** Get the positions of the constituents of a given type in increasing order */
+    const std::vector<unsigned int>& getConstituentsOfType(const Constituent::ConstituentType type) const
+    {
+        fillConstituentOrder();
+        return constituentsByType_[type];
+    }
+    /** Get the b-tag flags of the constituents, bit i (bit i%64 of word i/64) is set if constituent i has a b-tag discriminator above cvsCut and |eta| below etaCut.  The flags are calculated once per event for each pair of cuts, the reference stays valid until the next event. */
+    const std::vector<uint64_t>& getBTagBits(const double cvsCut, const double etaCut) const
+    {
+        for(const auto& bTagBits : bTagBits_)
+        {
+            if(bTagBits.cvsCut == cvsCut && bTagBits.etaCut == etaCut) return bTagBits.bits;
+        }
+
+        const std::vector<Constituent>& constituents = *constituents_;
+        bTagBits_.push_back({cvsCut, etaCut, std::vector<uint64_t>((constituents.size() + 63)/64, 0)});
+        std::vector<uint64_t>& bits = bTagBits_.back().bits;
+        for(unsigned int iConst = 0; iConst < constituents.size(); ++iConst)
+        {
+            if(constituents[iConst].getBTagDisc() > cvsCut && fabs(constituents[iConst].p().Eta()) < etaCut) bits[iConst >> 6] |= uint64_t(1) << (iConst & 63);
+        }
+        return bits;
+    }
+    /** Get the number of b-tagged constituents of a top object from the per event b-tag flags, with the same definition as TopObject::getNBConstituents */
+    int getNBConstituents(const TopObject& top, const double cvsCut, const double etaCut = 2.4) const
+    {
+        const std::vector<uint64_t>& bits = getBTagBits(cvsCut, etaCut);
+        int nb = 0;
+        for(const auto* constituent : top.getConstituents())
+        {
+            const size_t iConst = constituent - constituents_->data();
+            if(iConst < constituents_->size()) nb += (bits[iConst >> 6] >> (iConst & 63)) & 1;
+            else                               nb += constituent->getBTagDisc() > cvsCut && fabs(constituent->p().Eta()) < etaCut;
+        }
+        return nb;
+    }
+    /** Check if a top candidate was rejected by a prefilter module (e.g. TTMCascade) */
+    bool isRejected(const TopObject& topCand) const
+    {
+        const auto iCand = &topCand - topCandidates_.data();
+        return iCand >= 0 && static_cast<size_t>(iCand) < rejectedCandidates_.size() && rejectedCandidates_[iCand];
+    }
 };
 
 #endif
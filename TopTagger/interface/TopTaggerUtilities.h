@@ -12,6 +12,7 @@ class TopObject;
 class TopTaggerResults;
 
 #include "TopTagger/TopTagger/interface/Constituent.h"
+#include "TopTagger/TopTagger/interface/TopTaggerResults.h"
 #include "TopTagger/CfgParser/include/TTException.h"
 
 #include "TF1.h"
@@ -529,8 +530,23 @@ namespace ttUtility
     ///backwards compatability overload
     std::vector<Constituent> packageConstituents(const std::vector<TLorentzVector>& jetsLVec, const std::vector<double>& btagFactors, const std::vector<double>& qgLikelihood);
     
-    ///Tool to calcualte MT2 from tagger results
-    double calculateMT2(const TopTaggerResults& ttr, const TLorentzVector& metLVec);
+    ///Precision of the MT2 calculation.  The bisection stops once MT2 is known to within +-max(absTolerance, relTolerance*MT2)/2, or after maxIterations bisection steps.  The default (all zero) calculates MT2 to machine precision.
+    struct MT2Precision
+    {
+        ///Absolute tolerance on MT2 in GeV
+        double absTolerance;
+        ///Relative tolerance on MT2
+        double relTolerance;
+        ///Maximum number of bisection steps per pair of tops, 0 for no limit
+        unsigned int maxIterations;
+
+        MT2Precision(const double absTol = 0.0, const double relTol = 0.0, const unsigned int maxIter = 0) : absTolerance(absTol), relTolerance(relTol), maxIterations(maxIter) {}
+    };
+
+    ///Tool to calcualte MT2 from tagger results, this is thread safe.  If errorBound is given it is set to a bound on the difference to the exact MT2, which is at most max(absTolerance, relTolerance*MT2)/2 unless the maxIterations limit was reached.
+    double calculateMT2(const TopTaggerResults& ttr, const TLorentzVector& metLVec, const MT2Precision& precision = MT2Precision(), double* errorBound = nullptr);
+    ///Batched version of calculateMT2, mt2[i] is calculated from ttrs[i] and metLVecs[i].  Each call is independent, so a large batch can be split between threads.
+    void calculateMT2(const std::vector<const TopTaggerResults*>& ttrs, const std::vector<TLorentzVector>& metLVecs, std::vector<double>& mt2, const MT2Precision& precision = MT2Precision());
 
     //New MVA variable helper class
     /**
@@ -542,7 +558,20 @@ namespace ttUtility
     protected:
         float* basePtr_;
         int len_;
+
+        //Constituents of the current event, used to index the per jet caches
+        const Constituent* eventConstituents_;
+        int nEventConstituents_;
+
+        //Results of the current event, used for the pair kinematics cache (nullptr if setEventResults was not called)
+        const TopTaggerResults* eventResults_;
+
+        /**
+         *Get the position of a constituent in the current event, returns -1 if it is not part of the constituents given to setConstituents
+         */
+        int constituentIndex(const Constituent* constituent) const;
     public:
+        MVAInputCalculator();
         /**
          *The job of mapVars is to populate the internal offests for all variables in the input variable list with their memory location in the data array.  To be called only once.
          *@param vars list of variables used for the model
@@ -553,6 +582,16 @@ namespace ttUtility
          *@param data pointer to start of the data array which will be used as input to the MVA
          */
         virtual void setPtr(float* data) {basePtr_ = data;}
+        /**
+         *Set the constituents of the current event.  Variables which depend on a single constituent are then calculated only once per event and shared between all candidates built from it.  Must be called again for every new event before calculateVars; if it is never called nothing is cached.
+         *@param constituents the constituent list of the event, the constituents of the top candidates must point into this vector
+         */
+        virtual void setConstituents(const std::vector<Constituent>& constituents);
+        /**
+         *Set the results of the current event.  This calls setConstituents and in addition allows variables which depend on a pair of constituents to be taken from the pair kinematics cache of the event.
+         *@param ttResults the results of the event, the constituents of the top candidates must point into its constituent vector
+         */
+        void setEventResults(const TopTaggerResults& ttResults);
         /**
          *Calculate the requested variables and store the values directly in the input array for the MVA
          *@param topCand the top candidate to calculate the input variables for 
@@ -563,6 +602,17 @@ namespace ttUtility
          *@param topCand the top candidate to check
          */
         virtual bool checkCand(const TopObject&) = 0;
+        /**
+         *Get the type of the top candidates accepted by checkCand, the modules only loop over the candidates of this type.  Defaults to TopObject::ANY (all candidates).
+         */
+        virtual TopObject::Type getCandType() const { return TopObject::ANY; }
+        /**
+         *Calculate the variables for all candidates of an event, one row per candidate starting at the array given to setPtr.  The variables are shared between modules through the MVA input store of the TopTaggerResults: rows already calculated by another module are copied from the store, all other rows are calculated and added to the store.  Candidates for which the variables cannot be calculated are removed from cands so that row i always belongs to cands[i].  This also calls setEventResults.
+         *@param ttResults the results of the event, all candidates must point into its top candidate vector
+         *@param vars list of variables given to mapVars
+         *@param cands the candidates to calculate the variables for
+         */
+        void calculateEventVars(TopTaggerResults& ttResults, const std::vector<std::string>& vars, std::vector<TopObject*>& cands);
         /**
          *Base distructor to allow cleanup of derived classes when necessary
          */
@@ -581,6 +631,7 @@ namespace ttUtility
         void mapVars(const std::vector<std::string>&);
         bool calculateVars(const TopObject&, int);
         bool checkCand(const TopObject&);
+        TopObject::Type getCandType() const;
     };
 
     /**
@@ -591,11 +642,21 @@ namespace ttUtility
     private:
         int var_fj_sdmass_, var_fj_tau21_, var_fj_ptDR_, var_fj_rel_ptdiff_, var_sj1_ptD_, var_sj1_axis1_, var_sj1_mult_, var_sj2_ptD_, var_sj2_axis1_, var_sj2_mult_, var_sjmax_csv_, var_sd_n2_;
 
+        //All variables depend only on the AK8 jet, so they are cached per AK8 jet and copied to every candidate using it
+        enum CacheState : char {NOT_FILLED, FILLED, INVALID};
+        std::vector<int> mappedVars_;
+        std::vector<float> fatjetCache_;
+        std::vector<CacheState> fatjetCacheState_;
+
+        bool calculateFatjetVars(const Constituent& fatjet, float* row) const;
+
     public:
         BDTDijetInputCalculator();
         void mapVars(const std::vector<std::string>&);
+        void setConstituents(const std::vector<Constituent>&);
         bool calculateVars(const TopObject&, int);
         bool checkCand(const TopObject&);
+        TopObject::Type getCandType() const;
     };
 
     /**
@@ -683,11 +744,65 @@ namespace ttUtility
         int dTheta_[NCONST];
         int j12_m_[NCONST];
 
+        //The requested variables are compiled by mapVars into a list of operations so that calculateVars only does the necessary work
+        enum FeatureType
+        {
+            //top candidate variables
+            CAND_PT, CAND_P, CAND_ETA, CAND_PHI, CAND_M, CAND_DRMAX, CAND_DTHETAMIN, CAND_DTHETAMAX, DRPT_TOP, DRPT_W, SD_N2,
+            //jet variables in the lab frame (jets ordered by CSV)
+            LAB_JETVAR, LAB_DR, LAB_DR_3, LAB_PAIR_M,
+            //jet variables in the top rest frame (jets ordered by p in the rest frame)
+            RF_P, RF_JETVAR, RF_THETA_TOP, RF_PHI_TOP, RF_M, RF_ZERO, RF_DTHETA, RF_PAIR_M
+        };
+
+        //Lab frame quantities of a single jet, these are stored in the per event jet table
+        enum JetVarType {JET_M, JET_P, JET_PT, JET_ETA, JET_PHI, JET_CSV, JET_QGL, JET_EXTRAVAR};
+
+        struct JetVar
+        {
+            JetVarType type;
+            //extra variable name and relu bias for JET_EXTRAVAR
+            std::string var;
+            double bias;
+        };
+
+        struct FeatureOp
+        {
+            FeatureType type;
+            //position of the variable in the output row
+            int offset;
+            //jet indices used by the operation
+            int jet, jetNext, jetNNext;
+            //index in jetVars_ for *_JETVAR operations
+            int jetVar;
+        };
+
+        std::vector<FeatureOp> plan_;
+        std::vector<JetVar> jetVars_;
+        bool needRestFrame_;
+
+        //Per event jet table, jetVars_.size() entries per constituent, and scratch space for jets not in the table
+        std::vector<double> jetTable_;
+        std::vector<char> jetTableFilled_;
+        std::vector<double> jetScratch_;
+
+        //Scratch space for the pair kinematics of jets which are not in the event constituents
+        TopTaggerResults::ConstituentPair pairScratch_[NCONST];
+
+        void addOp(const FeatureType type, const int offset, const int jet = 0);
+        void addJetOp(const FeatureType type, const int offset, const int jet, const JetVarType jetVarType, const std::string& var = "", const double bias = 0.0);
+        void compilePlan();
+        void calculateJetVars(const Constituent& jet, double* values) const;
+        const double* getJetVars(const Constituent& jet, const int iJet);
+        const TopTaggerResults::ConstituentPair& getPair(const Constituent& jet1, const Constituent& jet2, const int iPair);
+
     public:
         TrijetInputCalculator();
         void mapVars(const std::vector<std::string>&);
+        void setConstituents(const std::vector<Constituent>&);
         bool calculateVars(const TopObject&, int);
         bool checkCand(const TopObject&);
+        TopObject::Type getCandType() const;
     };
 
     std::vector<std::string> getMVAVars();
@@ -707,6 +822,30 @@ namespace ttUtility
     //Originally from https://stackoverflow.com/questions/1902681/expand-file-names-that-have-environment-variables-in-their-path/20715800#20715800
     void autoExpandEnvironmentVariables(std::string&);
 
+    /**
+     *Read-only view of a file which is memory mapped where possible, such that all processes loading the same model file share one copy in the page cache.  If the file cannot be mapped it is read into a private buffer instead.  Environment variables in the file name are expanded.
+     */
+    class MappedFile
+    {
+    private:
+        const char* data_;
+        size_t size_;
+        bool mapped_;
+        std::vector<char> buffer_;
+
+    public:
+        MappedFile(const std::string& file);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ///Pointer to the file contents, valid for the lifetime of this object
+        const char* data() const;
+        ///Size of the file in bytes
+        size_t size() const;
+    };
+
 }
 
 #endif
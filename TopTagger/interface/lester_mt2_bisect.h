@@ -290,6 +290,7 @@ bool __private_ellipsesAreDisjoint(const double coeffLamPow3, const double coeff
 #include <iomanip>
 #include <cmath>
 #include <cassert>
+#include <atomic>
 
 
 class asymm_mt2_lester_bisect {
@@ -303,7 +304,11 @@ class asymm_mt2_lester_bisect {
     const double pxMiss, const double pyMiss,
     const double mInvis1, const double mInvis2,
     const double desiredPrecisionOnMT2=0, // This must be non-negative.  If set to zero (default) MT2 will be calculated to the highest precision available on the machine (or as close to that as the algorithm permits).  If set to a positive value, MT2 (note that is MT2, not its square) will be calculated to within +- desiredPrecisionOnMT2. Note that by requesting precision of +- 0.01 GeV on an MT2 value of 100 GeV can result in speedups of a factor of ...
-    const bool useDeciSectionsInitially=true // If true, interval is cut at the 10% point until first acceptance, which gives factor 3 increase in speed calculating kinematic min, but 3% slowdown for events in the bulk.  Is on (true) by default, but can be turned off by setting to false.
+    const bool useDeciSectionsInitially=true, // If true, interval is cut at the 10% point until first acceptance, which gives factor 3 increase in speed calculating kinematic min, but 3% slowdown for events in the bulk.  Is on (true) by default, but can be turned off by setting to false.
+    const double stopAboveMT2=0, // If positive, the calculation is stopped as soon as MT2 is known to be at least this value and a lower bound on MT2 which is >= stopAboveMT2 is returned instead of MT2.  This is used to skip the bisection when only the smallest of several MT2 values is needed.  Zero (default) disables this.
+    const double desiredRelativePrecisionOnMT2=0, // Must be non-negative.  If positive, the bisection also stops once the MT2 interval is smaller than desiredRelativePrecisionOnMT2 times its lower edge, i.e. MT2 is calculated to within +- desiredRelativePrecisionOnMT2*MT2/2.  The larger of the absolute and relative tolerance is used.
+    const unsigned int maxBisections=0, // If positive, at most this many bisection steps are made, whatever the precision reached.  Zero (default) means no limit.
+    double* const mT2ErrorBound=0 // If not null, set to a bound on |returned MT2 - MT2|, the half width of the final MT2 interval for the usual case.  Set to HUGE_VAL if the calculation was stopped by stopAboveMT2 (the returned value is then only a lower bound).
   ) {
 
     const double mT2_Sq = get_mT2_Sq(
@@ -312,7 +317,11 @@ class asymm_mt2_lester_bisect {
                             pxMiss,pyMiss,
                             mInvis1, mInvis2,
                             desiredPrecisionOnMT2,
-                            useDeciSectionsInitially);
+                            useDeciSectionsInitially,
+                            stopAboveMT2,
+                            desiredRelativePrecisionOnMT2,
+                            maxBisections,
+                            mT2ErrorBound);
     if (mT2_Sq==MT2_ERROR) {
       return MT2_ERROR;
     }
@@ -320,8 +329,9 @@ class asymm_mt2_lester_bisect {
   }
   
   static void disableCopyrightMessage(const bool printIfFirst=false) {
-    static bool first = true;
-    if (first && printIfFirst) {
+    // atomic so that MT2 can be calculated from several threads, the message is printed at most once
+    static std::atomic<bool> first(true);
+    if (first.exchange(false) && printIfFirst) {
     std::cout 
       << "\n\n"
       << "#=========================================================\n"
@@ -344,7 +354,6 @@ class asymm_mt2_lester_bisect {
       << "#=========================================================\n"
       << "\n\n" << std::flush;
     }
-    first = false;
   }
 
   static double get_mT2_Sq( // returns square of asymmetric mT2 (which is >=0), or returns a negative number (such as MT2_ERROR) in the case of an error.
@@ -353,7 +362,11 @@ class asymm_mt2_lester_bisect {
     const double pxMiss, const double pyMiss,
     const double mInvis1, const double mInvis2,
     const double desiredPrecisionOnMT2=0, // This must be non-negative.  If set to zero (default) MT2 will be calculated to the highest precision available on the machine (or as close to that as the algorithm permits).  If set to a positive value, MT2 (note that is MT2, not its square) will be calculated to within +- desiredPrecisionOnMT2. Note that by requesting precision of +- 0.01 GeV on an MT2 value of 100 GeV can resJult in speedups of a factor of ..
-    const bool useDeciSectionsInitially=true // If true, interval is cut at the 10% point until first acceptance, which gives factor 3 increase in speed calculating kinematic min, but 3% slowdown for events in the bulk.  Is on (true) by default, but can be turned off by setting to false.
+    const bool useDeciSectionsInitially=true, // If true, interval is cut at the 10% point until first acceptance, which gives factor 3 increase in speed calculating kinematic min, but 3% slowdown for events in the bulk.  Is on (true) by default, but can be turned off by setting to false.
+    const double stopAboveMT2=0, // If positive, the calculation is stopped as soon as MT2 is known to be at least this value and a lower bound on MT2 which is >= stopAboveMT2 is returned instead of MT2.  This is used to skip the bisection when only the smallest of several MT2 values is needed.  Zero (default) disables this.
+    const double desiredRelativePrecisionOnMT2=0, // Must be non-negative.  If positive, the bisection also stops once the MT2 interval is smaller than desiredRelativePrecisionOnMT2 times its lower edge, i.e. MT2 is calculated to within +- desiredRelativePrecisionOnMT2*MT2/2.  The larger of the absolute and relative tolerance is used.
+    const unsigned int maxBisections=0, // If positive, at most this many bisection steps are made, whatever the precision reached.  Zero (default) means no limit.
+    double* const mT2ErrorBound=0 // If not null, set to a bound on |returned MT2 - MT2|, the half width of the final MT2 interval for the usual case.  Set to HUGE_VAL if the calculation was stopped by stopAboveMT2 (the returned value is then only a lower bound).
       ) {
 
 
@@ -369,13 +382,21 @@ class asymm_mt2_lester_bisect {
                mVis1, pxVis1, pyVis1,
                pxMiss, pyMiss,
                mInvis2, mInvis1,
-               desiredPrecisionOnMT2
+               desiredPrecisionOnMT2,
+               useDeciSectionsInitially,
+               stopAboveMT2,
+               desiredRelativePrecisionOnMT2,
+               maxBisections,
+               mT2ErrorBound
              );
     }
 
     // By now, we can be sure that m1Min <= m2Min
     assert(m1Min<=m2Min);
 
+    // no bound unless one is found below (e.g. for MT2_ERROR)
+    if (mT2ErrorBound) *mT2ErrorBound = HUGE_VAL;
+
     const double mMin = m2Min; // when parent has this mass, both ellipses are physical, and at least one has zero size.  Note that the name "min" expresses that it is the minimum potential parent mass we should consider, not that it is the min of m1Min and m2Min.  It is in fact the MAX of them!
 
     // TODO: What about rounding?  What about idiots who give us mVis values that have been computed from E^2-p^2 terms that are perilously close to zero, or perilously degenerate?
@@ -403,6 +424,7 @@ class asymm_mt2_lester_bisect {
 #endif
     // Check for an easy MT2 zero, not because we think it will speed up many cases, but because it will allow us to, ever after, assume that scaleSq>0.
     if (scaleSq==0) {
+      if (mT2ErrorBound) *mT2ErrorBound = 0;
       return 0;
     }
     const double scale = sqrt(scaleSq);
@@ -430,6 +452,12 @@ class asymm_mt2_lester_bisect {
         break;
       }
 
+      // disjoint at mUpper, so MT2 is above mUpper
+      if (stopAboveMT2>0 && mUpper>=stopAboveMT2) {
+        if (mT2ErrorBound) *mT2ErrorBound = HUGE_VAL;
+        return mUpper*mUpper;
+      }
+
       if (attempts>=maxAttempts) {
         std::cerr << "MT2 algorithm failed to find upper bound to MT2" << std::endl;
         return MT2_ERROR;
@@ -445,7 +473,16 @@ class asymm_mt2_lester_bisect {
 
     // Now begin the bisection:
     bool goLow = useDeciSectionsInitially;
-    while(desiredPrecisionOnMT2<=0 || mUpper-mLower>desiredPrecisionOnMT2) {
+    unsigned int bisections = 0;
+    while(true) {
+      const double tolerance = lestermax(desiredPrecisionOnMT2, desiredRelativePrecisionOnMT2*mLower);
+      if (tolerance>0 && mUpper-mLower<=tolerance) {
+        break;
+      }
+      if (maxBisections>0 && bisections>=maxBisections) {
+        break;
+      }
+      ++bisections;
 
       const double trialM = ( goLow ?
                               (mLower*15+mUpper)/16  // bias low until evidence this is not a special case
@@ -458,6 +495,7 @@ class asymm_mt2_lester_bisect {
 #ifdef LESTER_DBG
         std::cout << " MACHINE_PREC " << std::setprecision(10) << mLower << " " << trialM << " " << mUpper << " " << mUpper-mLower << " " << desiredPrecisionOnMT2 << std::endl;
 #endif
+        if (mT2ErrorBound) *mT2ErrorBound = mUpper-mLower;
         return trialM*trialM;
       }
       const double trialMSq = trialM * trialM;
@@ -469,6 +507,10 @@ class asymm_mt2_lester_bisect {
         if (disjoint) {
           mLower = trialM;
           goLow = false;
+          if (stopAboveMT2>0 && mLower>=stopAboveMT2) {
+            if (mT2ErrorBound) *mT2ErrorBound = HUGE_VAL;
+            return mLower*mLower;
+          }
 #ifdef LESTER_DBG
           std::cout << "UP " ;
 #endif
@@ -483,11 +525,13 @@ class asymm_mt2_lester_bisect {
 #ifdef LESTER_DBG
         std::cout << " THROW " << std::endl;
 #endif
+        if (mT2ErrorBound) *mT2ErrorBound = mUpper-mLower;
         return mLower*mLower;
       }
     }
 
     const double mAns = (mLower+mUpper)/2.0;
+    if (mT2ErrorBound) *mT2ErrorBound = (mUpper-mLower)/2.0;
 
 #ifdef LESTER_DBG
     std::cout << " USER_PREC " << std::endl;
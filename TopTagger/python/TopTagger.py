@@ -57,6 +57,21 @@ class TopTaggerResult:
     def j3IdxCol(self):
         return self.intVals[:, 3]
 
+class TopTaggerChunkResult(TopTaggerResult):
+    def __init__(self, results):
+        TopTaggerResult.__init__(self, results)
+        self.offsets = results[2]
+
+    def nEvents(self):
+        return self.offsets.shape[0] - 1
+
+    def counts(self):
+        return self.offsets[1:] - self.offsets[:-1]
+
+    def event(self, iEvt):
+        first, last = self.offsets[iEvt], self.offsets[iEvt + 1]
+        return TopTaggerResult((self.floatVals[first:last], self.intVals[first:last]))
+
 class TopTagger:
 
     def __init__(self, cfgFile, workingDir = ""):
@@ -93,6 +108,16 @@ class TopTagger:
             results = tti.getResults(self.tt)
         return TopTaggerResult(results)
 
+    def runChunk(self, ak4Inputs = None, ak8Inputs = None, resolvedTopInputs = None, saveCandidates = False, nThreads = 1):
+        #inputs are flat arrays for a chunk of events with per event offsets, see the README for the tuple layout
+        #nThreads = N splits the events between N threads
+        inputs = {}
+        if ak4Inputs is not None:         inputs["ak4Inputs"] = ak4Inputs
+        if ak8Inputs is not None:         inputs["ak8Inputs"] = ak8Inputs
+        if resolvedTopInputs is not None: inputs["resolvedTopInputs"] = resolvedTopInputs
+        results = tti.runChunk(self.tt, saveCandidates = int(saveCandidates), nThreads = int(nThreads), **inputs)
+        return TopTaggerChunkResult(results)
+
     def runFromNanoAOD(self, event, isFirstEvent = False):
         #This is a hack for the nanoAOD postprocessor to force it to read all necessary variables before passing them to C because each new branch accessed causes all branches to be reallocated 
         nHackLoop = 1
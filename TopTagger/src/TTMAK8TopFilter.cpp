@@ -3,6 +3,7 @@
 #include "TopTagger/TopTagger/interface/TopTaggerResults.h"
 #include "TopTagger/CfgParser/include/Context.hh"
 #include "TopTagger/CfgParser/include/CfgDocument.hh"
+#include "TopTagger/CfgParser/include/TTException.h"
 
 void TTMAK8TopFilter::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& localContextName)
 {
@@ -11,8 +12,14 @@ void TTMAK8TopFilter::getParameters(const cfg::CfgDocument* cfgDoc, const std::s
     cfg::Context localCxt(localContextName);
     
     //Parameters
-    type_        = static_cast<TopObject::Type>(cfgDoc->get("type",        localCxt,  TopObject::MERGED_TOP));
+    int type     = cfgDoc->get("type",        localCxt,  TopObject::MERGED_TOP);
 
+    //An invalid type would otherwise throw from every event
+    if(type <= TopObject::NONE || type == TopObject::NTYPE || type > TopObject::ANY)
+    {
+        THROW_TTEXCEPTION("ERROR: Invalid candidate type " + std::to_string(type) + " for \"" + localContextName + "\"");
+    }
+    type_ = static_cast<TopObject::Type>(type);
 }
 
 void TTMAK8TopFilter::run(TopTaggerResults& ttResults)
@@ -23,12 +30,9 @@ void TTMAK8TopFilter::run(TopTaggerResults& ttResults)
     std::vector<TopObject*>& tops = ttResults.getTops();
 
     //This class adds the merged objects to the final top list 
-    for(auto& topCand : topCandidates)
+    for(unsigned int iCand : ttResults.getCandidatesOfType(type_))
     {
         //For now this just adds the merged tops
-        if(topCand.getType() == type_)
-        {
-            tops.push_back(&topCand);
-        }
+        tops.push_back(&topCandidates[iCand]);
     }    
 }
@@ -31,6 +31,8 @@ void TTMBasicClusterAlgo::getParameters(const cfg::CfgDocument* cfgDoc, const st
     midTrijetAK4JetPt_  = cfgDoc->get("midTrijetAK4JetPt", localCxt, -999.0);
     maxTrijetAK4JetPt_  = cfgDoc->get("maxTrijetAK4JetPt", localCxt, -999.0);
 
+    skipDuplicates_     = cfgDoc->get("skipDuplicates",    localCxt,  false);
+
     //get vars for TTMConstituentReqs
     TTMConstituentReqs::getParameters(cfgDoc, localContextName);
 }
@@ -40,16 +42,25 @@ void TTMBasicClusterAlgo::run(TopTaggerResults& ttResults)
     const std::vector< Constituent>& constituents = ttResults.getConstituents();
     std::vector<TopObject>& topCandidates = ttResults.getTopCandidates();
 
-    std::vector<const Constituent*> constituentsCSVSort;
+    //Flag the nbSeed_ highest csv jets passing the trijet requirements, using the per event b-tag ordering
+    std::vector<char> isBSeed(constituents.size(), false);
     if(nbSeed_ > 0)
     {
-        for(const auto& constituent : constituents)
+        int nSeed = 0;
+        for(unsigned int iConst : ttResults.getConstituentBTagOrder())
         {
-            if(passAK4ResolvedReqs(constituent, minTrijetAK4JetPt_)) constituentsCSVSort.push_back(&constituent);
+            if(nSeed >= nbSeed_) break;
+            if(passAK4ResolvedReqs(constituents[iConst], minTrijetAK4JetPt_))
+            {
+                isBSeed[iConst] = true;
+                ++nSeed;
+            }
         }
-        std::sort(constituentsCSVSort.begin(), constituentsCSVSort.end(), [](const Constituent* c1, const Constituent* c2) { return c1->getBTagDisc() > c2->getBTagDisc(); } );
     }
 
+    //AK8/AK4 overlaps for the dijet candidates are computed once for the event
+    if(doDijet_) buildOverlapMatrix(constituents, dRMatch_, dRMatchAK8_);
+
     for(unsigned int i = 0; i < constituents.size(); ++i)
     {
         //singlet tops
@@ -61,13 +72,13 @@ void TTMBasicClusterAlgo::run(TopTaggerResults& ttResults)
                 TopObject topCand({&constituents[i]}, TopObject::MERGED_TOP);
                 topCand.setDiscriminator(constituents[i].getTopDisc());
 
-                topCandidates.push_back(topCand);
+                if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
             }
             else if (!useDeepAK8_ && passAK8TopReqs(constituents[i]))
             {
                 TopObject topCand({&constituents[i]}, TopObject::MERGED_TOP);
 
-                topCandidates.push_back(topCand);
+                if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
             }
         }
 
@@ -80,13 +91,13 @@ void TTMBasicClusterAlgo::run(TopTaggerResults& ttResults)
                 TopObject topCand({&constituents[i]}, TopObject::MERGED_W);
                 topCand.setDiscriminator(constituents[i].getTopDisc());
 
-                topCandidates.push_back(topCand);
+                if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
             }
             else if (!useDeepAK8_ && passAK8WReqs(constituents[i]))
             {
                 TopObject topCand({&constituents[i]}, TopObject::MERGED_W);
 
-                topCandidates.push_back(topCand);
+                if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
             }            
         }
 
@@ -103,15 +114,16 @@ void TTMBasicClusterAlgo::run(TopTaggerResults& ttResults)
                     //the AK8 jet is passed to ensure the AK4 jet does not overlap with it
                     if(i == j || !passAK4WReqs(constituents[j], constituents[i])) continue;
 
-                    TopObject topCand({&constituents[i], &constituents[j]}, TopObject::SEMIMERGEDWB_TOP);
-
-                    //mass window on the top candidate mass
-                    double m123 = topCand.p().M();
+                    //mass window on the top candidate mass, taken from the pair cache so that the candidate is only built if it passes
+                    double m123 = ttResults.getConstituentPair(i, j).m;
                     bool passMassWindow = (minTopCandMass_ < m123) && (m123 < maxTopCandMass_);
+                    if(!passMassWindow) continue;
 
-                    if(topCand.getDRmax() < dRMaxDiJet_ && passMassWindow)
+                    TopObject topCand({&constituents[i], &constituents[j]}, TopObject::SEMIMERGEDWB_TOP);
+
+                    if(topCand.getDRmax() < dRMaxDiJet_)
                     {
-                        topCandidates.push_back(topCand);
+                        if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
                     }
                 }
             }
@@ -133,18 +145,9 @@ void TTMBasicClusterAlgo::run(TopTaggerResults& ttResults)
                                 if(nbSeed_ > 0)
                                 {
                                     //Require that each combination contain at least one of the nbSeed_ highest csv jets 
-                                    bool reject = true;
-                                    for(int l = 0; l < std::min(nbSeed_, static_cast<int>(constituentsCSVSort.size())); ++l)
-                                    {
-                                        if(&constituents[k] == constituentsCSVSort[l] || &constituents[j] == constituentsCSVSort[l] || &constituents[i] == constituentsCSVSort[l])
-                                        {
-                                            reject = false;
-                                            break;
-                                        }
-                                    }
-                                    if(reject) continue;
+                                    if(!isBSeed[i] && !isBSeed[j] && !isBSeed[k]) continue;
                                 }
-                                fillTriplet(&constituents[k], &constituents[j], &constituents[i], topCandidates);
+                                fillTriplet(&constituents[k], &constituents[j], &constituents[i], ttResults);
                             }
                         }
                     }
@@ -152,10 +155,14 @@ void TTMBasicClusterAlgo::run(TopTaggerResults& ttResults)
             }
         }
     }
+
+    if(doDijet_) clearOverlapMatrix();
 }
 
-void TTMBasicClusterAlgo::fillTriplet(const Constituent* const c1, const Constituent* const c2, const Constituent* const c3, std::vector<TopObject>& topCandidates)
+void TTMBasicClusterAlgo::fillTriplet(const Constituent* const c1, const Constituent* const c2, const Constituent* const c3, TopTaggerResults& ttResults)
 {
+    std::vector<TopObject>& topCandidates = ttResults.getTopCandidates();
+
     TopObject topCand({c1, c2, c3}, TopObject::RESOLVED_TOP);
 
     //mass window on the top candidate mass
@@ -164,6 +171,6 @@ void TTMBasicClusterAlgo::fillTriplet(const Constituent* const c1, const Constit
 
     if(topCand.getDRmax() < dRMaxTrijet_ && passMassWindow)
     {
-        topCandidates.push_back(topCand);
+        if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
     }
 }
@@ -0,0 +1,115 @@
+#include "TopTagger/TopTagger/interface/TTMCascade.h"
+
+#include "TopTagger/TopTagger/interface/TopTaggerResults.h"
+#include "TopTagger/CfgParser/include/Context.hh"
+#include "TopTagger/CfgParser/include/CfgDocument.hh"
+#include "TopTagger/CfgParser/include/TTException.h"
+
+#include <cmath>
+#include <limits>
+
+void TTMCascade::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& localContextName)
+{
+    //Construct contexts
+    cfg::Context commonCxt("Common");
+    cfg::Context localCxt(localContextName);
+
+    int type       = cfgDoc->get("type",         localCxt, -1);
+    bias_          = cfgDoc->get("bias",         localCxt, 0.0);
+    cut_           = cfgDoc->get("cut",          localCxt, std::numeric_limits<double>::quiet_NaN());
+    rejectedDisc_  = cfgDoc->get("rejectedDisc", localCxt, -999.9);
+    topMass_       = cfgDoc->get("topMass",      localCxt, 173.0);
+
+    csvThreshold_  = cfgDoc->get("csvThreshold", localCxt, -999.9);
+    bEtaCut_       = cfgDoc->get("bEtaCut",      localCxt, -999.9);
+
+    //The prefilter rejects candidates, so it must not silently run with a default selection
+    if(type <= TopObject::NONE || type == TopObject::NTYPE || type > TopObject::ANY)
+    {
+        THROW_TTEXCEPTION("ERROR: Prefilter \"" + localContextName + "\" requires a valid candidate \"type\"");
+    }
+    type_ = static_cast<TopObject::Type>(type);
+
+    if(std::isnan(cut_))
+    {
+        THROW_TTEXCEPTION("ERROR: Prefilter \"" + localContextName + "\" requires a \"cut\"");
+    }
+
+    //Get variable names
+    std::vector<std::string> varNames;
+    cfgDoc->getArray("var", localCxt, varNames);
+
+    if(varNames.empty())
+    {
+        THROW_TTEXCEPTION("ERROR: Prefilter \"" + localContextName + "\" requires at least one \"var\"");
+    }
+
+    for(unsigned int iVar = 0; iVar < varNames.size(); ++iVar)
+    {
+        const std::string& varName = varNames[iVar];
+
+        if(     varName.compare("cand_pt") == 0)        vars_.push_back(CAND_PT);
+        else if(varName.compare("cand_eta") == 0)       vars_.push_back(CAND_ETA);
+        else if(varName.compare("cand_m") == 0)         vars_.push_back(CAND_M);
+        else if(varName.compare("cand_dm") == 0)        vars_.push_back(CAND_DM);
+        else if(varName.compare("cand_dRMax") == 0)     vars_.push_back(CAND_DRMAX);
+        else if(varName.compare("cand_dThetaMin") == 0) vars_.push_back(CAND_DTHETAMIN);
+        else if(varName.compare("cand_dThetaMax") == 0) vars_.push_back(CAND_DTHETAMAX);
+        else if(varName.compare("cand_nb") == 0)        vars_.push_back(CAND_NB);
+        else
+        {
+            THROW_TTEXCEPTION("ERROR: Unknown prefilter variable \"" + varName + "\"");
+        }
+
+        const double weight = cfgDoc->get("weight", iVar, localCxt, std::numeric_limits<double>::quiet_NaN());
+        if(std::isnan(weight))
+        {
+            THROW_TTEXCEPTION("ERROR: Prefilter \"" + localContextName + "\" requires a \"weight\" for variable \"" + varName + "\"");
+        }
+        weights_.push_back(weight);
+    }
+}
+
+double TTMCascade::evaluate(const TopObject& topCand, const TopTaggerResults& ttResults) const
+{
+    double score = bias_;
+    for(unsigned int iVar = 0; iVar < vars_.size(); ++iVar)
+    {
+        double value = 0.0;
+        switch(vars_[iVar])
+        {
+        case CAND_PT:        value = topCand.p().Pt();                                        break;
+        case CAND_ETA:       value = topCand.p().Eta();                                       break;
+        case CAND_M:         value = topCand.p().M();                                         break;
+        case CAND_DM:        value = std::abs(topCand.p().M() - topMass_);                    break;
+        case CAND_DRMAX:     value = topCand.getDRmax();                                      break;
+        case CAND_DTHETAMIN: value = topCand.getDThetaMin();                                  break;
+        case CAND_DTHETAMAX: value = topCand.getDThetaMax();                                  break;
+        case CAND_NB:        value = ttResults.getNBConstituents(topCand, csvThreshold_, bEtaCut_); break;
+        }
+        score += weights_[iVar]*value;
+    }
+    return score;
+}
+
+void TTMCascade::run(TopTaggerResults& ttResults)
+{
+    //Get the list of top candidates as generated by the clustering algo
+    std::vector<TopObject>& topCandidates = ttResults.getTopCandidates();
+    //Get the list of rejected candidates which the later modules will skip
+    std::vector<bool>& rejected = ttResults.getRejectedCandidates();
+
+    rejected.resize(topCandidates.size(), false);
+
+    //Only the candidates of the selected type are considered
+    for(unsigned int iCand : ttResults.getCandidatesOfType(type_))
+    {
+        auto& topCand = topCandidates[iCand];
+
+        if(evaluate(topCand, ttResults) < cut_)
+        {
+            rejected[iCand] = true;
+            topCand.setDiscriminator(rejectedDisc_);
+        }
+    }
+}
@@ -57,12 +57,8 @@ bool TTMConstituentReqs::passAK4WReqs(const Constituent& constituent, const Cons
     //basic AK4 jet requirements 
     bool basicReqs = constituent.getType() == Constituent::AK4JET && constituent.p().Pt() > minAK4WPt_;
 
-    //check that the AK4 jet does not overlap with the selected AK8 subjets
-    //to keep the algorithm from needing to do unnecessary calculations on all matches
-    //we have to have the AK8 jet in the first position, not the second arguement
-    bool overlapCheck = constituentsAreUsed({&constituentAK8}, {&constituent}, dRMatch_, dRMatchAK8_);
-
-    return basicReqs && !overlapCheck;
+    //check that the AK4 jet does not overlap with the selected AK8 subjets (looked up in the overlap matrix if it was built for this event)
+    return basicReqs && !constituentOverlaps(constituentAK8, constituent, dRMatch_, dRMatchAK8_);
 }
 
 bool TTMConstituentReqs::passAK8TopReqs(const Constituent& constituent) const
@@ -16,11 +16,18 @@ void TTMDiscriminatorFilter::getParameters(const cfg::CfgDocument* cfgDoc, const
     discOffset_    = cfgDoc->get("discOffset",    localCxt, 999.9);
     discSlope_     = cfgDoc->get("discSlope",     localCxt, 0.0);
 
-    type_          = static_cast<TopObject::Type>(cfgDoc->get("type",    localCxt, 0));
+    int type       = cfgDoc->get("type",    localCxt, -1);
 
     bdiscThreshold_  = cfgDoc->get("bdiscThreshold", localCxt, -999.9);
     bEtaCut_         = cfgDoc->get("bEtaCut",        localCxt, -999.9);
     maxNbInTop_      = cfgDoc->get("maxNbInTop",     localCxt, -1);
+
+    //An invalid type would otherwise throw from every event
+    if(type <= TopObject::NONE || type == TopObject::NTYPE || type > TopObject::ANY)
+    {
+        THROW_TTEXCEPTION("ERROR: Discriminator filter \"" + localContextName + "\" requires a valid candidate \"type\"");
+    }
+    type_ = static_cast<TopObject::Type>(type);
 }
 
 void TTMDiscriminatorFilter::run(TopTaggerResults& ttResults)
@@ -30,24 +37,28 @@ void TTMDiscriminatorFilter::run(TopTaggerResults& ttResults)
     //Get the list of final tops into which we will stick candidates
     std::vector<TopObject*>& tops = ttResults.getTops();
 
+    //The cuts are applied to the columns of the candidate table for the candidates of the selected type only
+    const auto& table = ttResults.getCandidateTable();
+    const std::vector<unsigned int>& typeCands = ttResults.getCandidatesOfType(type_);
+    const unsigned int nCand = typeCands.size();
+
+    //Check number of b-tagged jets in the top
+    if(maxNbInTop_ >= 0) ttResults.countBConstituents(bdiscThreshold_, bEtaCut_, nb_);
+    else                 nb_.assign(table.size(), 0);
 
     //Apply discriminator and b multiplicity cuts 
-    for(auto& topCand : topCandidates)
+    pass_.resize(nCand);
+    for(unsigned int i = 0; i < nCand; ++i)
+    {
+        const unsigned int iCand = typeCands[i];
+        pass_[i] = (table.disc[iCand] > std::min(discriminator_, discOffset_ + table.pt[iCand]*discSlope_))
+            && (maxNbInTop_ < 0 || nb_[iCand] <= maxNbInTop_);
+    }
+
+    //place in final top list if it passes the threshold
+    for(unsigned int i = 0; i < nCand; ++i)
     {
-        //Check the top type
-        if(topCand.getType() != type_) continue;
-
-        //get discriminator
-        double passDiscriminator = topCand.getDiscriminator() > std::min(discriminator_, discOffset_ + topCand.p().Pt()*discSlope_);
-        
-        //Check number of b-tagged jets in the top
-        bool passBrequirements = maxNbInTop_ < 0 || topCand.getNBConstituents(bdiscThreshold_, bEtaCut_) <= maxNbInTop_;
-        
-        //place in final top list if it passes the threshold
-        if(passDiscriminator && passBrequirements)
-        {
-            tops.push_back(&topCand);
-        }
+        if(pass_[i]) tops.push_back(&topCandidates[typeCands[i]]);
     }
 }
 
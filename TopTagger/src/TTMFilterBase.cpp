@@ -6,6 +6,85 @@
 
 #include "Math/VectorUtil.h"
 
+TTMFilterBase::TTMFilterBase() : overlapConstituents_(nullptr), nOverlapConstituents_(0), nOverlapWords_(0), overlapDRMax_(-999.9), overlapDRMaxAK8_(-999.9)
+{
+}
+
+bool TTMFilterBase::constituentCovers(const Constituent& constituentAK8, const Constituent& constituent, const double dRMax, const double dRMaxAK8) const
+{
+    if(constituentAK8.getSubjets().size() <= 1)
+    {
+        // If this jet has only one subjet, use matching to the overall AK8 jet instead 
+        return ROOT::Math::VectorUtil::DeltaR(constituentAK8.p(), constituent.p()) < dRMaxAK8;
+    }
+    else
+    {
+        for(const auto& subjet : constituentAK8.getSubjets())
+        {
+            if(ROOT::Math::VectorUtil::DeltaR(subjet.p(), constituent.p()) < dRMax) return true;
+        }
+    }
+
+    return false;
+}
+
+void TTMFilterBase::buildOverlapMatrix(const std::vector<Constituent>& allConstituents, const double dRMax, const double dRMaxAK8)
+{
+    overlapConstituents_ = allConstituents.data();
+    nOverlapConstituents_ = allConstituents.size();
+    nOverlapWords_ = (nOverlapConstituents_ + 63)/64;
+    overlapDRMax_ = dRMax;
+    overlapDRMaxAK8_ = dRMaxAK8;
+    overlapMatrix_.assign(nOverlapConstituents_*nOverlapWords_, 0);
+    overlapRowFilled_.assign(nOverlapConstituents_, false);
+}
+
+void TTMFilterBase::clearOverlapMatrix()
+{
+    //The matrix points into the constituents of the current event, forget it so it cannot be used once they are gone
+    overlapConstituents_ = nullptr;
+    nOverlapConstituents_ = 0;
+    nOverlapWords_ = 0;
+}
+
+const uint64_t* TTMFilterBase::overlapRow(const size_t index) const
+{
+    uint64_t* row = overlapMatrix_.data() + index*nOverlapWords_;
+    if(!overlapRowFilled_[index])
+    {
+        const Constituent& constituentAK8 = overlapConstituents_[index];
+        if(constituentAK8.getType() == Constituent::AK8JET)
+        {
+            for(size_t iMatch = 0; iMatch < nOverlapConstituents_; ++iMatch)
+            {
+                if(constituentCovers(constituentAK8, overlapConstituents_[iMatch], overlapDRMax_, overlapDRMaxAK8_)) row[iMatch >> 6] |= uint64_t(1) << (iMatch & 63);
+            }
+        }
+        overlapRowFilled_[index] = true;
+    }
+    return row;
+}
+
+size_t TTMFilterBase::overlapIndex(const Constituent* constituent) const
+{
+    const size_t index = constituent - overlapConstituents_;
+    return (overlapConstituents_ != nullptr && index < nOverlapConstituents_) ? index : nOverlapConstituents_;
+}
+
+bool TTMFilterBase::constituentOverlaps(const Constituent& constituentAK8, const Constituent& constituent, const double dRMax, const double dRMaxAK8) const
+{
+    const size_t iAK8 = overlapIndex(&constituentAK8);
+    const size_t iConst = overlapIndex(&constituent);
+    //the matrix can only be used if it was built with the same matching requirements
+    if(iAK8 < nOverlapConstituents_ && iConst < nOverlapConstituents_ && dRMax == overlapDRMax_ && dRMaxAK8 == overlapDRMaxAK8_)
+    {
+        //only AK8 jets can cover other constituents
+        return constituentAK8.getType() == Constituent::AK8JET && ((overlapRow(iAK8)[iConst >> 6] >> (iConst & 63)) & 1);
+    }
+
+    return constituentAK8.getType() == Constituent::AK8JET && constituentCovers(constituentAK8, constituent, dRMax, dRMaxAK8);
+}
+
 bool TTMFilterBase::constituentsAreUsed(const std::vector<const Constituent*>& constituents, const std::set<const Constituent*>& usedConsts, const double dRMax, const double dRMaxAK8) const
 {
     for(const auto& constituent : constituents)
@@ -18,30 +97,12 @@ bool TTMFilterBase::constituentsAreUsed(const std::vector<const Constituent*>& c
         else if(constituent->getType() == Constituent::AK8JET)
         {
             //If the constituent is AK8 we will also check its subjets are not used
-            if(constituent->getSubjets().size() <= 1)
-            {
-                // If this jet has only one subjet, use matching to the overall AK8 jet instead 
-                for(const auto& usedConstituent : usedConsts)
-                {
-                    if(ROOT::Math::VectorUtil::DeltaR(constituent->p(), usedConstituent->p()) < dRMaxAK8)
-                    {
-                        //we found a match
-                        return true;
-                    }
-                }
-            }
-            else
+            for(const auto& usedConstituent : usedConsts)
             {
-                for(const auto& subjet : constituent->getSubjets())
+                if(constituentCovers(*constituent, *usedConstituent, dRMax, dRMaxAK8))
                 {
-                    for(const auto& usedConstituent : usedConsts)
-                    {
-                        if(ROOT::Math::VectorUtil::DeltaR(subjet.p(), usedConstituent->p()) < dRMax)
-                        {
-                            //we found a match
-                            return true;
-                        }
-                    }
+                    //we found a match
+                    return true;
                 }
             }
         }
@@ -61,32 +122,52 @@ void TTMFilterBase::markConstituentsUsed(const std::vector<const Constituent *>&
         //If the constituent is an AK8JET, then add AK4JETs matching its subjets as well 
         if(constituent->getType() == Constituent::AK8JET)
         {
-            if(constituent->getSubjets().size() <= 1)
-            {
-                //If there is one or fewer subjets, instead match to the overall AK8 jet
-                for(const auto& matchConst : allConstituents) 
-                {
-                    if(ROOT::Math::VectorUtil::DeltaR(constituent->p(), matchConst.p()) < dRMaxAK8)
-                    {
-                        usedConstituents.insert(&matchConst);
-                    }
-                }
-            }
-            else
+            for(const auto& matchConst : allConstituents) 
             {
-                for(const auto& subjet : constituent->getSubjets())
+                if(constituentCovers(*constituent, matchConst, dRMax, dRMaxAK8))
                 {
-                    for(const auto& matchConst : allConstituents) 
-                    {
-                        if(ROOT::Math::VectorUtil::DeltaR(subjet.p(), matchConst.p()) < dRMax)
-                        {
-                            usedConstituents.insert(&matchConst);
-                        }
-                    }
+                    usedConstituents.insert(&matchConst);
                 }
             }
         }
     }
 }
 
+bool TTMFilterBase::constituentsAreUsed(const std::vector<const Constituent*>& constituents, const std::vector<uint64_t>& usedBits) const
+{
+    for(const auto& constituent : constituents)
+    {
+        const size_t iConst = overlapIndex(constituent);
+        if(iConst >= nOverlapConstituents_) continue;
+
+        //First return true if constituent is found (this covers all AK4 and most AK8 jets)
+        if((usedBits[iConst >> 6] >> (iConst & 63)) & 1) return true;
+
+        //If the constituent is AK8 we will also check the constituents it covers are not used
+        if(constituent->getType() != Constituent::AK8JET) continue;
+        const uint64_t* row = overlapRow(iConst);
+        for(size_t iWord = 0; iWord < nOverlapWords_; ++iWord)
+        {
+            if(row[iWord] & usedBits[iWord]) return true;
+        }
+    }
+
+    //if nothing is found then we have an unused jet
+    return false;
+}
+
+void TTMFilterBase::markConstituentsUsed(const std::vector<const Constituent *>& constituents, std::vector<uint64_t>& usedBits) const
+{
+    for(const auto& constituent : constituents)
+    {
+        const size_t iConst = overlapIndex(constituent);
+        if(iConst >= nOverlapConstituents_) continue;
+
+        //No matter what, add the main constituent, and for AK8 jets also all constituents it covers
+        usedBits[iConst >> 6] |= uint64_t(1) << (iConst & 63);
 
+        if(constituent->getType() != Constituent::AK8JET) continue;
+        const uint64_t* row = overlapRow(iConst);
+        for(size_t iWord = 0; iWord < nOverlapWords_; ++iWord) usedBits[iWord] |= row[iWord];
+    }
+}
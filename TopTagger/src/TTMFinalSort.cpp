@@ -24,16 +24,30 @@ void TTMFinalSort::run(TopTaggerResults& ttResults)
 {
     //Get vector of final tops to sort
     std::vector<TopObject*>& tops = ttResults.getTops();
-    std::map<TopObject::Type, std::vector<TopObject*>>& topsByType = ttResults.getTopsByType();
+    auto& topsByType = ttResults.getTopsByType();
+
+    //The sort keys are taken from the columns of the candidate table, tops which are not top candidates are calculated directly
+    const auto& table = ttResults.getCandidateTable();
+    const TopObject* firstCand = ttResults.getTopCandidates().data();
+    auto candIndex = [&](const TopObject* top){ return static_cast<size_t>(top - firstCand); };
+    auto applySort = [&](const bool descending)
+    {
+        if(descending) std::sort(sortKeys_.begin(), sortKeys_.end(), [](const std::pair<double, TopObject*>& k1, const std::pair<double, TopObject*>& k2){ return k1.first > k2.first; } );
+        else           std::sort(sortKeys_.begin(), sortKeys_.end(), [](const std::pair<double, TopObject*>& k1, const std::pair<double, TopObject*>& k2){ return k1.first < k2.first; } );
+        for(unsigned int iTop = 0; iTop < tops.size(); ++iTop) tops[iTop] = sortKeys_[iTop].second;
+    };
 
     //Sort the top vector for overlap resolution
+    sortKeys_.clear();
     if(sortMethod_.compare("topMass") == 0)
     {
-        std::sort(tops.begin(), tops.end(), [this](TopObject* t1, TopObject* t2){ return fabs(t1->p().M() - this->mt_) < fabs(t2->p().M() - this->mt_); } );
+        for(TopObject* top : tops) sortKeys_.emplace_back(fabs(((candIndex(top) < table.size()) ? table.m[candIndex(top)] : top->p().M()) - mt_), top);
+        applySort(false);
     }
     else if(sortMethod_.compare("topPt") == 0)
     {
-        std::sort(tops.begin(), tops.end(), [this](TopObject* t1, TopObject* t2){ return t1->p().Pt() > t2->p().Pt(); } );
+        for(TopObject* top : tops) sortKeys_.emplace_back((candIndex(top) < table.size()) ? table.pt[candIndex(top)] : top->p().Pt(), top);
+        applySort(true);
     }
     else if(sortMethod_.compare("none") == 0)
     {
@@ -0,0 +1,270 @@
+#include "TopTagger/TopTagger/interface/TTMGlobalOverlapResolution.h"
+
+#include "TopTagger/TopTagger/interface/TopTaggerResults.h"
+#include "TopTagger/CfgParser/include/Context.hh"
+#include "TopTagger/CfgParser/include/TTException.h"
+#include "TopTagger/CfgParser/include/CfgDocument.hh"
+
+#include <set>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <chrono>
+
+TTMGlobalOverlapResolution::TTMGlobalOverlapResolution() : nCands_(0), nWords_(0), bestWeight_(0.0), nNodes_(0), budgetExceeded_(false), timing_{0, 0, 0, 0.0}
+{
+}
+
+void TTMGlobalOverlapResolution::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& localContextName)
+{
+    //Construct contexts
+    cfg::Context commonCxt("Common");
+    cfg::Context localCxt(localContextName);
+
+    maxTopEta_    = cfgDoc->get("maxTopEta",    commonCxt, -999.9);
+    dRMatch_      = cfgDoc->get("dRMatch",      commonCxt, -999.9);
+    dRMatchAK8_   = cfgDoc->get("dRMatchAK8",   commonCxt, 0.8);
+
+    type_          = static_cast<TopObject::Type>(cfgDoc->get("NConstituents", localCxt,  TopObject::ANY));
+    nodeBudget_    = cfgDoc->get("nodeBudget",    localCxt,  10000);
+    markUsed_      = cfgDoc->get("markUsed",      localCxt,  true);
+
+    std::string objective = cfgDoc->get("objective", localCxt, "mvaDisc");
+    if     (objective.compare("mvaDisc") == 0) objective_ = MVADISC;
+    else if(objective.compare("nTops") == 0)   objective_ = NTOPS;
+    else
+    {
+        THROW_TTEXCEPTION("Invalid objective option \"" + objective + "\"");
+    }
+}
+
+double TTMGlobalOverlapResolution::upperBound(const uint64_t* available)
+{
+    //Cover the available tops greedily with cliques of mutually conflicting tops, at most one top per clique can be selected
+    //The tops are ordered by weight so the first top of each clique has the largest weight
+    uint64_t* remaining = boundScratch_.data();
+    uint64_t* clique = remaining + nWords_;
+    std::copy(available, available + nWords_, remaining);
+
+    double bound = 0.0;
+    for(int iWord = 0; iWord < nWords_; ++iWord)
+    {
+        while(remaining[iWord])
+        {
+            const int iCand = iWord*64 + __builtin_ctzll(remaining[iWord]);
+            bound += weights_[iCand];
+            remaining[iWord] &= remaining[iWord] - 1;
+
+            //Add the tops conflicting with all tops already in the clique
+            const uint64_t* conflicts = &conflicts_[iCand*nWords_];
+            for(int jWord = iWord; jWord < nWords_; ++jWord) clique[jWord] = remaining[jWord] & conflicts[jWord];
+            for(int jWord = iWord; jWord < nWords_; ++jWord)
+            {
+                while(clique[jWord])
+                {
+                    const int jCand = jWord*64 + __builtin_ctzll(clique[jWord]);
+                    remaining[jWord] &= ~(uint64_t(1) << (jCand & 63));
+                    const uint64_t* jConflicts = &conflicts_[jCand*nWords_];
+                    for(int kWord = jWord; kWord < nWords_; ++kWord) clique[kWord] &= jConflicts[kWord];
+                }
+            }
+        }
+    }
+
+    return bound;
+}
+
+void TTMGlobalOverlapResolution::search(int depth, double weight)
+{
+    ++nNodes_;
+
+    //The current selection is always a valid solution
+    if(weight > bestWeight_ + 1e-9)
+    {
+        bestWeight_ = weight;
+        bestSelection_ = selection_;
+    }
+
+    const uint64_t* available = &searchStack_[depth*nWords_];
+
+    int iWord = 0;
+    while(iWord < nWords_ && !available[iWord]) ++iWord;
+    if(iWord == nWords_) return;
+
+    //Stop if the remaining tops can not improve on the best solution or the search is out of budget
+    if(weight + upperBound(available) <= bestWeight_ + 1e-9) return;
+    if(nNodes_ >= nodeBudget_)
+    {
+        budgetExceeded_ = true;
+        return;
+    }
+
+    //Branch on the available top with the largest weight
+    const int iCand = iWord*64 + __builtin_ctzll(available[iWord]);
+    uint64_t* next = &searchStack_[(depth + 1)*nWords_];
+    const uint64_t* conflicts = &conflicts_[iCand*nWords_];
+
+    //First select the top, removing all tops conflicting with it
+    for(int jWord = 0; jWord < nWords_; ++jWord) next[jWord] = available[jWord] & ~conflicts[jWord];
+    next[iWord] &= ~(uint64_t(1) << (iCand & 63));
+    selection_.push_back(iCand);
+    search(depth + 1, weight + weights_[iCand]);
+    selection_.pop_back();
+
+    //Then reject the top (the stack entry for depth + 1 is overwritten by the first branch)
+    for(int jWord = 0; jWord < nWords_; ++jWord) next[jWord] = available[jWord];
+    next[iWord] &= ~(uint64_t(1) << (iCand & 63));
+    search(depth + 1, weight);
+}
+
+void TTMGlobalOverlapResolution::solve()
+{
+    //Start from the greedy solution, accepting tops in order of weight
+    bestSelection_.clear();
+    bestWeight_ = 0.0;
+    std::vector<uint64_t> taken(nWords_, 0);
+    for(int iCand = 0; iCand < nCands_; ++iCand)
+    {
+        if((taken[iCand >> 6] >> (iCand & 63)) & 1) continue;
+
+        bestSelection_.push_back(iCand);
+        bestWeight_ += weights_[iCand];
+        for(int iWord = 0; iWord < nWords_; ++iWord) taken[iWord] |= conflicts_[iCand*nWords_ + iWord];
+    }
+
+    //Then search for a better solution, the stack holds the available tops for each depth
+    searchStack_.assign((nCands_ + 1)*nWords_, 0);
+    boundScratch_.resize(2*nWords_);
+    for(int iCand = 0; iCand < nCands_; ++iCand) searchStack_[iCand >> 6] |= uint64_t(1) << (iCand & 63);
+    selection_.clear();
+    nNodes_ = 0;
+    budgetExceeded_ = false;
+    search(0, 0.0);
+
+    timing_.nNodesTotal += nNodes_;
+    if(budgetExceeded_) ++timing_.nBudgetExceeded;
+}
+
+void TTMGlobalOverlapResolution::run(TopTaggerResults& ttResults)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    //Get list of constituents used to construct tops
+    const std::vector< Constituent>& constituents = ttResults.getConstituents();
+
+    //Get vector of final tops to prune
+    std::vector<TopObject*>& tops = ttResults.getTops();
+
+    //This container will keep track of which jets have been included in final tops
+    std::set<Constituent const *>& usedJets = ttResults.getUsedConstituents();
+
+    //Compute which constituents are covered by each AK8 jet once for the event
+    buildOverlapMatrix(constituents, dRMatch_, dRMatchAK8_);
+
+    //The used jets are tracked as a bitset indexed by position in the constituent list
+    const int nConstWords = (constituents.size() + 63)/64;
+    std::vector<uint64_t> usedBits(nConstWords, 0);
+    for(const auto* jet : usedJets)
+    {
+        const size_t iJet = jet - constituents.data();
+        if(iJet < constituents.size()) usedBits[iJet >> 6] |= uint64_t(1) << (iJet & 63);
+    }
+
+    //Collect the tops to resolve, tops failing the eta requirement or using constituents of earlier tops are removed
+    std::vector<TopObject*> optional;
+    cands_.clear();
+    std::vector<char> keep(tops.size(), true);
+    for(unsigned int iTop = 0; iTop < tops.size(); ++iTop)
+    {
+        auto* top = tops[iTop];
+        if((type_ != TopObject::ANY) && (top->getType() != type_)) continue;
+
+        keep[iTop] = false;
+        if(fabs(top->p().Eta()) >= maxTopEta_ || constituentsAreUsed(top->getConstituents(), usedBits)) continue;
+
+        //Tops which can not increase the total discriminator are only added after the search where they do not conflict
+        if(objective_ == MVADISC && top->getDiscriminator() <= 0.0) optional.push_back(top);
+        else                                                       cands_.push_back(top);
+    }
+
+    //Order the tops by weight, this is the order used by the greedy solution and for branching
+    auto byDisc = [](const TopObject* t1, const TopObject* t2){ return t1->getDiscriminator() > t2->getDiscriminator(); };
+    std::stable_sort(cands_.begin(), cands_.end(), byDisc);
+    std::stable_sort(optional.begin(), optional.end(), byDisc);
+
+    nCands_ = cands_.size();
+    nWords_ = (nCands_ + 63)/64;
+    weights_.resize(nCands_);
+    for(int iCand = 0; iCand < nCands_; ++iCand) weights_[iCand] = (objective_ == MVADISC) ? cands_[iCand]->getDiscriminator() : 1.0;
+
+    //Mask of the constituents each top would mark as used, two tops conflict if their masks overlap
+    constituentMasks_.assign(nCands_*nConstWords, 0);
+    std::vector<uint64_t> mask(nConstWords);
+    for(int iCand = 0; iCand < nCands_; ++iCand)
+    {
+        std::fill(mask.begin(), mask.end(), 0);
+        markConstituentsUsed(cands_[iCand]->getConstituents(), mask);
+        std::copy(mask.begin(), mask.end(), constituentMasks_.begin() + iCand*nConstWords);
+    }
+
+    conflicts_.assign(nCands_*nWords_, 0);
+    for(int iCand = 0; iCand < nCands_; ++iCand)
+    {
+        for(int jCand = 0; jCand < iCand; ++jCand)
+        {
+            bool overlaps = false;
+            for(int iWord = 0; iWord < nConstWords && !overlaps; ++iWord) overlaps = constituentMasks_[iCand*nConstWords + iWord] & constituentMasks_[jCand*nConstWords + iWord];
+            if(overlaps)
+            {
+                conflicts_[iCand*nWords_ + (jCand >> 6)] |= uint64_t(1) << (jCand & 63);
+                conflicts_[jCand*nWords_ + (iCand >> 6)] |= uint64_t(1) << (iCand & 63);
+            }
+        }
+    }
+
+    bestSelection_.clear();
+    if(nCands_ > 0) solve();
+
+    //Collect the selected tops and mark their constituents as used
+    std::set<const TopObject*> selected;
+    std::vector<uint64_t> selectedBits(nConstWords, 0);
+    for(const int iCand : bestSelection_)
+    {
+        selected.insert(cands_[iCand]);
+        for(int iWord = 0; iWord < nConstWords; ++iWord) selectedBits[iWord] |= constituentMasks_[iCand*nConstWords + iWord];
+    }
+    for(auto* top : optional)
+    {
+        std::fill(mask.begin(), mask.end(), 0);
+        markConstituentsUsed(top->getConstituents(), mask);
+
+        bool overlaps = false;
+        for(int iWord = 0; iWord < nConstWords && !overlaps; ++iWord) overlaps = mask[iWord] & selectedBits[iWord];
+        if(overlaps) continue;
+
+        selected.insert(top);
+        for(int iWord = 0; iWord < nConstWords; ++iWord) selectedBits[iWord] |= mask[iWord];
+    }
+
+    //Remove the rejected tops keeping the original order
+    auto iKeep = tops.begin();
+    for(unsigned int iTop = 0; iTop < tops.size(); ++iTop)
+    {
+        if(keep[iTop] || selected.count(tops[iTop])) *(iKeep++) = tops[iTop];
+    }
+    tops.erase(iKeep, tops.end());
+
+    //Add the selected tops constituents to the set tracking which constituents have been used
+    if(markUsed_)
+    {
+        for(size_t iJet = 0; iJet < constituents.size(); ++iJet)
+        {
+            if((selectedBits[iJet >> 6] >> (iJet & 63)) & 1) usedJets.insert(usedJets.end(), &constituents[iJet]);
+        }
+    }
+
+    clearOverlapMatrix();
+
+    ++timing_.nEvents;
+    timing_.totalTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
@@ -34,43 +34,67 @@ void TTMHEPRequirements::run(TopTaggerResults& ttResults)
     //Get the list of final tops into which we will stick candidates
     std::vector<TopObject*>& tops = ttResults.getTops();
 
-    for(auto& topCand : topCandidates)
+    //The trijet requirements are applied to the columns of the candidate table
+    const auto& table = ttResults.getCandidateTable();
+    const unsigned int nCand = table.size();
+
+    //Gather the pair masses of the trijets, the pair masses are shared between all candidates of the event
+    m12_.assign(nCand, 0.0);
+    m23_.assign(nCand, 0.0);
+    m13_.assign(nCand, 0.0);
+    if(doTrijet_)
     {
+        for(unsigned int iCand = 0; iCand < nCand; ++iCand)
+        {
+            if(table.nConstituents[iCand] != 3) continue;
+
+            const std::vector<Constituent const *>& jets = topCandidates[iCand].getConstituents();
+            m12_[iCand] = ttResults.getConstituentPair(*jets[0], *jets[1]).m;
+            m23_[iCand] = ttResults.getConstituentPair(*jets[1], *jets[2]).m;
+            m13_[iCand] = ttResults.getConstituentPair(*jets[0], *jets[2]).m;
+        }
+
+        //Requirements on b-quarks
+        ttResults.countBConstituents(csvThresh_, bEtaCut_, nb_);
+    }
+
+    //Implement HEP mass ratio requirements here, 0.2 < atan(m13/m12) < 1.3 is applied as a cut on m13/m12 directly
+    const double tanMin = tan(0.2), tanMax = tan(1.3);
+    const double Rmin2 = Rmin_*Rmin_, Rmax2 = Rmax_*Rmax_;
+    pass_.assign(nCand, false);
+    for(unsigned int iCand = 0; iCand < nCand && doTrijet_; ++iCand)
+    {
+        const double m123 = table.m[iCand];
+        const double r13 = m13_[iCand]/m12_[iCand];
+        const double r12 = m12_[iCand]/m13_[iCand];
+        const double r23 = m23_[iCand]/m123;
+        const double rhs = 1 - r23*r23;
+
+        bool criterionA = tanMin < r13 &&
+            r13 < tanMax &&
+            Rmin_ < r23 &&
+            r23 < Rmax_;
+
+        bool criterionB = (Rmin2*(1 + r13*r13) < rhs) && (rhs < Rmax2*(1 + r13*r13));
+
+        bool criterionC = (Rmin2*(1 + r12*r12) < rhs) && (rhs < Rmax2*(1 + r12*r12));
+
+        pass_[iCand] = table.nConstituents[iCand] == 3 && (criterionA || criterionB || criterionC) && nb_[iCand] <= maxNbInTop_;
+    }
+
+    for(unsigned int iCand = 0; iCand < nCand; ++iCand)
+    {
+        auto& topCand = topCandidates[iCand];
+
         //Grab the list of constituents which make up this top candidate 
         const std::vector<Constituent const *>& jets = topCand.getConstituents();
 
         //HEP tagger requirements
         bool passHEPRequirments = false;
 
-        //Get the total candidate mass
-        double m123 = topCand.p().M();
-
         if(doTrijet_ && jets.size() == 3) //trijets
         {
-            double m12  = (jets[0]->p() + jets[1]->p()).M();
-            double m23  = (jets[1]->p() + jets[2]->p()).M();
-            double m13  = (jets[0]->p() + jets[2]->p()).M();
-
-            //Implement HEP mass ratio requirements here
-            bool criterionA = 0.2 < atan(m13/m12) &&
-                atan(m13/m12) < 1.3 &&
-                Rmin_ < m23/m123 &&
-                m23/m123 < Rmax_;
-
-            bool criterionB = (pow(Rmin_, 2)*(1+pow(m13/m12, 2)) < (1 - pow(m23/m123, 2))) &&
-                ((1 - pow(m23/m123, 2)) < pow(Rmax_, 2)*(1 + pow(m13/m12, 2)));// &&
-            //(m23/m123 > 0.35);
-
-            bool criterionC = (pow(Rmin_, 2)*(1+pow(m12/m13, 2)) < (1 - pow(m23/m123, 2))) &&
-                ((1 - pow(m23/m123, 2)) < pow(Rmax_, 2)*(1 + pow(m12/m13, 2)));// &&
-            //(m23/m123 > 0.35);
-
-            //Requirements on b-quarks
-            int Nb = 0;
-            for(const auto& jet : jets) if(jet->getBTagDisc() > csvThresh_ && fabs(jet->p().Eta()) < bEtaCut_) ++Nb;
-            bool passBrequirements = (Nb <= maxNbInTop_);
-
-            passHEPRequirments = (criterionA || criterionB || criterionC) && passBrequirements;
+            passHEPRequirments = pass_[iCand];
         }
         else if(doDijet_ && jets.size() == 2) //dijets
         {
@@ -78,7 +102,7 @@ void TTMHEPRequirements::run(TopTaggerResults& ttResults)
             //small hack for legacy tagger
             if(jets[0]->getType() == Constituent::AK4JET && jets[1]->getType() == Constituent::AK4JET) m23 = jets[0]->p().M();
 
-            double m123 = topCand.p().M();
+            double m123 = table.m[iCand];
             if(jets[0]->getType() == Constituent::AK8JET)
             {
                 TLorentzVector psudoVec;
@@ -23,6 +23,7 @@ void TTMLazyClusterAlgo::getParameters(const cfg::CfgDocument* cfgDoc, const std
     doMonojet_      = cfgDoc->get("doMonojet",      localCxt,  false);
     doDijet_        = cfgDoc->get("doDijet",        localCxt,  false);
     doTrijet_       = cfgDoc->get("doTrijet",       localCxt,  false);
+    skipDuplicates_ = cfgDoc->get("skipDuplicates", localCxt,  false);
 }
 
 void TTMLazyClusterAlgo::run(TopTaggerResults& ttResults)
@@ -41,7 +42,7 @@ void TTMLazyClusterAlgo::run(TopTaggerResults& ttResults)
             {
                 TopObject topCand({&constituents[i]});
 
-                topCandidates.push_back(topCand);
+                if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
             }
         }
 
@@ -60,7 +61,7 @@ void TTMLazyClusterAlgo::run(TopTaggerResults& ttResults)
                 
                     if(topCand.getDRmax() < dRMax_)
                     {
-                        topCandidates.push_back(topCand);
+                        if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
                     }
                 }
             }
@@ -85,7 +86,7 @@ void TTMLazyClusterAlgo::run(TopTaggerResults& ttResults)
 
                     if(topCand.getDRmax() < dRMax_ && passMassWindow)
                     {
-                        topCandidates.push_back(topCand);
+                        if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
                     }
                 }
             }
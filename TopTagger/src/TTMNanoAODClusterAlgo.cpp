@@ -18,6 +18,8 @@ void TTMNanoAODClusterAlgo::getParameters(const cfg::CfgDocument* cfgDoc, const
     //trijet parameters
     doTrijet_           = cfgDoc->get("doTrijet",          localCxt,  false);
 
+    skipDuplicates_     = cfgDoc->get("skipDuplicates",    localCxt,  false);
+
     //get vars for TTMConstituentReqs
     TTMConstituentReqs::getParameters(cfgDoc, localContextName);
 }
@@ -38,7 +40,7 @@ void TTMNanoAODClusterAlgo::run(TopTaggerResults& ttResults)
                 TopObject topCand({&constituents[i]}, TopObject::MERGED_TOP);
                 topCand.setDiscriminator(constituents[i].getTopDisc());
 
-                topCandidates.push_back(topCand);
+                if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
             }
         }
 
@@ -51,7 +53,7 @@ void TTMNanoAODClusterAlgo::run(TopTaggerResults& ttResults)
                 TopObject topCand({&constituents[i]}, TopObject::MERGED_W);
                 topCand.setDiscriminator(constituents[i].getTopDisc());
 
-                topCandidates.push_back(topCand);
+                if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
             }
         }
 
@@ -91,7 +93,7 @@ void TTMNanoAODClusterAlgo::run(TopTaggerResults& ttResults)
                     TopObject topCand(resolvedTopConstituents, TopObject::RESOLVED_TOP);
                     topCand.setDiscriminator(constituents[i].getTopDisc());
 
-                    topCandidates.push_back(topCand);
+                    if(!skipDuplicates_ || !ttResults.hasTopCandidate(topCand)) topCandidates.push_back(topCand);
                 }
                 else
                 {
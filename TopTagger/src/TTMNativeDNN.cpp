@@ -0,0 +1,568 @@
+#include "TopTagger/TopTagger/interface/TTMNativeDNN.h"
+
+#include "TopTagger/TopTagger/interface/TopTaggerUtilities.h"
+#include "TopTagger/TopTagger/interface/TopObject.h"
+#include "TopTagger/TopTagger/interface/TopTaggerResults.h"
+#include "TopTagger/CfgParser/include/Context.hh"
+#include "TopTagger/CfgParser/include/CfgDocument.hh"
+#include "TopTagger/CfgParser/include/TTException.h"
+
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+//IEEE half precision conversions (round to nearest even), infinities and NaN are not needed for network weights and are not preserved by halfToFloat
+static inline float halfToFloat(const uint16_t h)
+{
+    //shift the exponent and mantissa into place and fix the exponent bias with a multiplication by 2^112, this also handles denormals
+    uint32_t bits = static_cast<uint32_t>(h & 0x7fff) << 13;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    f *= 5.192296858534828e+33f;
+    memcpy(&bits, &f, sizeof(f));
+    bits |= static_cast<uint32_t>(h & 0x8000) << 16;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline uint16_t floatToHalf(const float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    const uint16_t sign = (bits >> 16) & 0x8000;
+    bits &= 0x7fffffff;
+
+    //too large for half precision (or inf/NaN)
+    if(bits >= 0x477ff000) return sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00);
+
+    //denormal, let the floating point addition do the rounding
+    if(bits < 0x38800000)
+    {
+        float tmp;
+        memcpy(&tmp, &bits, sizeof(tmp));
+        tmp += 0.5f;
+        memcpy(&bits, &tmp, sizeof(bits));
+        return sign | static_cast<uint16_t>(bits - 0x3f000000);
+    }
+
+    //normal, rebias the exponent and round the mantissa to nearest even
+    const uint32_t mantissaOdd = (bits >> 13) & 1;
+    bits += 0xc8000fff + mantissaOdd;
+    return sign | static_cast<uint16_t>(bits >> 13);
+}
+
+void TTMNativeDNN::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& localContextName)
+{
+    //Construct contexts
+    cfg::Context commonCxt("Common");
+    cfg::Context localCxt(localContextName);
+
+    discriminator_ = cfgDoc->get("discCut",       localCxt, -999.9);
+    discOffset_    = cfgDoc->get("discOffset",    localCxt, 999.9);
+    discSlope_     = cfgDoc->get("discSlope",     localCxt, 0.0);
+    modelFile_     = cfgDoc->get("modelFile",     localCxt, "");
+    NConstituents_ = cfgDoc->get("NConstituents", localCxt, 3);
+    saveInputs_    = cfgDoc->get("saveInputs",    localCxt, false);
+    std::string precision = cfgDoc->get("precision", localCxt, "float");
+    calibrationFile_   = cfgDoc->get("calibrationFile",   localCxt, "");
+    calibrationWindow_ = cfgDoc->get("calibrationWindow", localCxt, 0.05);
+
+    csvThreshold_  = cfgDoc->get("csvThreshold", localCxt, -999.9);
+    bEtaCut_       = cfgDoc->get("bEtaCut",      localCxt, -999.9);
+    maxNbInTop_    = cfgDoc->get("maxNbInTop",   localCxt, -1);
+
+    std::string modelFileFullPath;
+    if(workingDirectory_.size()) modelFileFullPath = workingDirectory_ + "/" + modelFile_;
+    else                         modelFileFullPath = modelFile_;
+
+    //Get variable names
+    cfgDoc->getArray("mvaVar", localCxt, vars_);
+
+    if(     precision.compare("float") == 0) precision_ = FP32;
+    else if(precision.compare("fp16") == 0)  precision_ = FP16;
+    else if(precision.compare("int8") == 0)  precision_ = INT8;
+    else
+    {
+        THROW_TTEXCEPTION("ERROR: Unknown precision \"" + precision + "\", must be \"float\", \"fp16\" or \"int8\"");
+    }
+
+    //Read the network weights
+    loadModel(modelFileFullPath);
+    quantizeModel();
+
+    if(layers_.front().nIn != static_cast<int>(vars_.size()))
+    {
+        THROW_TTEXCEPTION("ERROR: Model \"" + modelFile_ + "\" expects " + std::to_string(layers_.front().nIn) + " inputs but " + std::to_string(vars_.size()) + " mvaVar were provided");
+    }
+
+    //Correct the reduced precision network using the fixed calibration set so the result does not depend on the events processed
+    calibration_ = Calibration();
+    if(precision_ != FP32 && calibrationFile_.size())
+    {
+        if(workingDirectory_.size()) calibrate(workingDirectory_ + "/" + calibrationFile_);
+        else                         calibrate(calibrationFile_);
+    }
+
+    //load variables
+    if(NConstituents_ == 1)
+    {
+        varCalculator_.reset(new ttUtility::BDTMonojetInputCalculator());
+    }
+    else if(NConstituents_ == 2)
+    {
+        varCalculator_.reset(new ttUtility::BDTDijetInputCalculator());
+    }
+    else if(NConstituents_ == 3)
+    {
+        varCalculator_.reset(new ttUtility::TrijetInputCalculator());
+    }
+    //map variables
+    varCalculator_->mapVars(vars_);
+}
+
+void TTMNativeDNN::run(TopTaggerResults& ttResults)
+{
+    //Get the list of top candidates as generated by the clustering algo
+    std::vector<TopObject>& topCandidates = ttResults.getTopCandidates();
+    //Get the list of final tops into which we will stick candidates
+    std::vector<TopObject*>& tops = ttResults.getTops();
+
+    std::vector<TopObject*> validCands;
+    //Only the candidates of the type handled by the variable calculator are considered
+    for(unsigned int iCand : ttResults.getCandidatesOfType(varCalculator_->getCandType()))
+    {
+        auto& topCand = topCandidates[iCand];
+
+        //Skip candidates already rejected by a prefilter module
+        if(ttResults.isRejected(topCand)) continue;
+
+        //Prepare data from top candidate (this code is shared with training tuple producer)
+        if(varCalculator_->checkCand(topCand))
+        {
+            validCands.emplace_back(&topCand);
+        }
+    }
+
+    if(validCands.empty()) return;
+
+    //Fill the input matrix with one row per candidate
+    inputBuf_.resize(validCands.size() * vars_.size());
+    varCalculator_->setPtr(inputBuf_.data());
+    varCalculator_->calculateEventVars(ttResults, vars_, validCands);
+
+    const int nCand = validCands.size();
+    if(saveInputs_)
+    {
+        for(int iCand = 0; iCand < nCand; ++iCand)
+        {
+            float *start = inputBuf_.data() + vars_.size() * iCand;
+            float *end = start + vars_.size();
+            validCands[iCand]->storeMVAInputs(vars_, start, end);
+        }
+    }
+
+    //Propagate the whole batch through the network
+    const int nOut = layers_.back().nOut;
+    const float* discriminators = evaluateNetwork(inputBuf_.data(), nCand, precision_);
+
+    //Get output discriminators
+    for(int iCand = 0; iCand < nCand; ++iCand)
+    {
+        auto* topCand = validCands[iCand];
+
+        //discriminators is a 2D array, we only want the first entry of every array
+        double discriminator = static_cast<double>(discriminators[iCand*nOut]) + calibration_.discShift;
+        topCand->setDiscriminator(discriminator);
+
+        //Check number of b-tagged jets in the top
+        bool passBrequirements = maxNbInTop_ < 0 || ttResults.getNBConstituents(*topCand, csvThreshold_, bEtaCut_) <= maxNbInTop_;
+
+        //place in final top list if it passes the threshold
+        if(discriminator > getThreshold(topCand->p().Pt()) && passBrequirements)
+        {
+            tops.push_back(topCand);
+        }
+    }
+}
+
+double TTMNativeDNN::getThreshold(double pt) const
+{
+    return std::min(discriminator_, discOffset_ + pt*discSlope_);
+}
+
+void TTMNativeDNN::calibrate(const std::string& file)
+{
+    //File layout (all values little endian, 4 bytes each)
+    //  char[8]  magic "TTDNNCAL"
+    //  uint32   version
+    //  uint32   number of candidates nCand
+    //  uint32   number of inputs nIn
+    //  float    pt[nCand]
+    //  float    inputs[nCand*nIn] (one row per candidate, in the order of mvaVar)
+    ttUtility::MappedFile calibrationData(file);
+    const char* data = calibrationData.data();
+    const size_t size = calibrationData.size();
+
+    size_t pos = 0;
+    auto checkSize = [&](size_t nBytes)
+    {
+        if(pos + nBytes > size)
+        {
+            THROW_TTEXCEPTION("ERROR: Calibration file \"" + file + "\" is truncated");
+        }
+    };
+    auto read = [&](void* dest, size_t nBytes)
+    {
+        checkSize(nBytes);
+        memcpy(dest, data + pos, nBytes);
+        pos += nBytes;
+    };
+
+    char magic[8];
+    uint32_t version, nCand, nIn;
+    read(magic, sizeof(magic));
+    read(&version, sizeof(version));
+    read(&nCand, sizeof(nCand));
+    read(&nIn, sizeof(nIn));
+
+    if(memcmp(magic, "TTDNNCAL", sizeof(magic)) != 0 || version != 1)
+    {
+        THROW_TTEXCEPTION("ERROR: \"" + file + "\" is not a native DNN calibration file (version 1)");
+    }
+
+    if(static_cast<int>(nIn) != layers_.front().nIn)
+    {
+        THROW_TTEXCEPTION("ERROR: Calibration file \"" + file + "\" has " + std::to_string(nIn) + " inputs but model \"" + modelFile_ + "\" expects " + std::to_string(layers_.front().nIn));
+    }
+
+    //all fields are 4 bytes, so the arrays are aligned for float access and are read in place
+    checkSize(static_cast<size_t>(nCand)*(nIn + 1)*sizeof(float));
+    const float* pt = reinterpret_cast<const float*>(data + pos);
+    const float* inputs = pt + nCand;
+
+    //Evaluate the calibration set with both networks, the full precision output is kept as it is overwritten by the next evaluation
+    const int nOut = layers_.back().nOut;
+    const float* fullDisc = evaluateNetwork(inputs, nCand, FP32);
+    std::vector<float> fullDiscCopy(fullDisc, fullDisc + nCand*nOut);
+    const float* reducedDisc = evaluateNetwork(inputs, nCand, precision_);
+
+    //Correct the reduced precision discriminator by the mean shift at the working point
+    calibration_ = Calibration();
+    calibration_.nCand = nCand;
+    double sumShift = 0.0;
+    for(unsigned int iCand = 0; iCand < nCand; ++iCand)
+    {
+        const double full = fullDiscCopy[iCand*nOut];
+        const double reduced = reducedDisc[iCand*nOut];
+        if(std::abs(full - getThreshold(pt[iCand])) < calibrationWindow_)
+        {
+            ++calibration_.nWorkingPoint;
+            sumShift += full - reduced;
+        }
+    }
+
+    if(calibration_.nWorkingPoint > 0) calibration_.discShift = sumShift/calibration_.nWorkingPoint;
+
+    //Change of the tagging efficiency at the working point on the calibration set
+    int nPassFull = 0, nPassReduced = 0, nPassCorrected = 0;
+    for(unsigned int iCand = 0; iCand < nCand; ++iCand)
+    {
+        const double threshold = getThreshold(pt[iCand]);
+        const double reduced = reducedDisc[iCand*nOut];
+        if(fullDiscCopy[iCand*nOut] > threshold)           ++nPassFull;
+        if(reduced > threshold)                            ++nPassReduced;
+        if(reduced + calibration_.discShift > threshold)   ++nPassCorrected;
+    }
+
+    if(nCand > 0)
+    {
+        calibration_.passFractionFull      = static_cast<double>(nPassFull)/nCand;
+        calibration_.passFractionReduced   = static_cast<double>(nPassReduced)/nCand;
+        calibration_.passFractionCorrected = static_cast<double>(nPassCorrected)/nCand;
+    }
+}
+
+TTMNativeDNN::~TTMNativeDNN()
+{
+}
+
+const float* TTMNativeDNN::evaluateNetwork(const float* input, int nRows, Precision precision)
+{
+    //Propagate the whole batch through the network one layer at a time
+    const float* in = input;
+    int iBuf = 0;
+    for(const auto& layer : layers_)
+    {
+        auto& out = layerBuf_[iBuf];
+        out.resize(nRows * layer.nOut);
+        switch(precision)
+        {
+        case FP32: evaluateLayer(layer, in, out.data(), nRows);     break;
+        case FP16: evaluateLayerFP16(layer, in, out.data(), nRows); break;
+        case INT8: evaluateLayerInt8(layer, in, out.data(), nRows); break;
+        }
+        in = out.data();
+        iBuf = 1 - iBuf;
+    }
+
+    return in;
+}
+
+void TTMNativeDNN::evaluateLayer(const Layer& layer, const float* in, float* out, int nRows) const
+{
+    const int nIn = layer.nIn;
+    const int nOut = layer.nOut;
+    const float* weights = layer.weights;
+    const float* biases = layer.biases;
+
+    //out = in * W + b, the inner loop runs over contiguous memory in both out and W so that it is vectorized by the compiler
+    for(int iRow = 0; iRow < nRows; ++iRow)
+    {
+        const float* x = in + iRow*nIn;
+        float* y = out + iRow*nOut;
+
+        std::copy(biases, biases + nOut, y);
+        for(int k = 0; k < nIn; ++k)
+        {
+            const float xk = x[k];
+            const float* w = weights + k*nOut;
+            for(int j = 0; j < nOut; ++j)
+            {
+                y[j] += xk * w[j];
+            }
+        }
+
+        applyActivation(layer.activation, y, nOut);
+    }
+}
+
+void TTMNativeDNN::evaluateLayerFP16(const Layer& layer, const float* in, float* out, int nRows)
+{
+    const int nIn = layer.nIn;
+    const int nOut = layer.nOut;
+    const uint16_t* weights = layer.weightsFP16.data();
+    const float* biases = layer.biases;
+
+    //same as evaluateLayer, but the weights are read in half precision and each weight row is expanded once for a block of candidates
+    constexpr int BLOCK = 16;
+    expandedWeights_.resize(nOut);
+    float* wf = expandedWeights_.data();
+    for(int iBlock = 0; iBlock < nRows; iBlock += BLOCK)
+    {
+        const int blockEnd = std::min(iBlock + BLOCK, nRows);
+
+        for(int iRow = iBlock; iRow < blockEnd; ++iRow) std::copy(biases, biases + nOut, out + iRow*nOut);
+        for(int k = 0; k < nIn; ++k)
+        {
+            const uint16_t* w = weights + k*nOut;
+            for(int j = 0; j < nOut; ++j) wf[j] = halfToFloat(w[j]);
+
+            for(int iRow = iBlock; iRow < blockEnd; ++iRow)
+            {
+                const float xk = in[iRow*nIn + k];
+                float* y = out + iRow*nOut;
+                for(int j = 0; j < nOut; ++j)
+                {
+                    y[j] += xk * wf[j];
+                }
+            }
+        }
+
+        //activations are stored in half precision
+        for(int iRow = iBlock; iRow < blockEnd; ++iRow)
+        {
+            float* y = out + iRow*nOut;
+            applyActivation(layer.activation, y, nOut);
+            for(int j = 0; j < nOut; ++j) y[j] = halfToFloat(floatToHalf(y[j]));
+        }
+    }
+}
+
+void TTMNativeDNN::evaluateLayerInt8(const Layer& layer, const float* in, float* out, int nRows)
+{
+    const int nIn = layer.nIn;
+    const int nOut = layer.nOut;
+    const int8_t* weights = layer.weightsInt8.data();
+    const float* scales = layer.weightScales.data();
+    const float* biases = layer.biases;
+
+    quantizedInput_.resize(nIn);
+    accumulator_.resize(nOut);
+    int16_t* xq = quantizedInput_.data();
+    int32_t* acc = accumulator_.data();
+
+    for(int iRow = 0; iRow < nRows; ++iRow)
+    {
+        const float* x = in + iRow*nIn;
+        float* y = out + iRow*nOut;
+
+        //quantize the inputs of this candidate symmetrically to [-127, 127]
+        float xMax = 0.0;
+        for(int k = 0; k < nIn; ++k) xMax = std::max(xMax, std::abs(x[k]));
+        const float xScale = (xMax > 0.0f) ? xMax/127.0f : 1.0f;
+        for(int k = 0; k < nIn; ++k) xq[k] = static_cast<int16_t>(std::lrint(x[k]/xScale));
+
+        //integer accumulation, |sum| <= 127*127*nIn does not overflow for any reasonable layer size
+        std::fill(acc, acc + nOut, 0);
+        for(int k = 0; k < nIn; ++k)
+        {
+            const int32_t xk = xq[k];
+            if(xk == 0) continue;
+            //the weights are widened to 32 bits in the multiply, so only one byte per weight is read from memory
+            const int8_t* w = weights + k*nOut;
+            for(int j = 0; j < nOut; ++j)
+            {
+                acc[j] += xk * static_cast<int32_t>(w[j]);
+            }
+        }
+
+        for(int j = 0; j < nOut; ++j) y[j] = acc[j]*xScale*scales[j] + biases[j];
+
+        applyActivation(layer.activation, y, nOut);
+    }
+}
+
+void TTMNativeDNN::applyActivation(Activation activation, float* y, int nOut) const
+{
+    switch(activation)
+    {
+    case RELU:
+        for(int j = 0; j < nOut; ++j) y[j] = std::max(y[j], 0.0f);
+        break;
+    case SIGMOID:
+        for(int j = 0; j < nOut; ++j) y[j] = 1.0f/(1.0f + std::exp(-y[j]));
+        break;
+    case TANH:
+        for(int j = 0; j < nOut; ++j) y[j] = std::tanh(y[j]);
+        break;
+    case SOFTMAX:
+    {
+        //subtract the max for numerical stability, as is done by tf.nn.softmax
+        const float maxVal = *std::max_element(y, y + nOut);
+        float sum = 0.0;
+        for(int j = 0; j < nOut; ++j)
+        {
+            y[j] = std::exp(y[j] - maxVal);
+            sum += y[j];
+        }
+        for(int j = 0; j < nOut; ++j) y[j] /= sum;
+        break;
+    }
+    case LINEAR:
+        break;
+    }
+}
+
+void TTMNativeDNN::quantizeModel()
+{
+    for(auto& layer : layers_)
+    {
+        layer.weightsFP16.clear();
+        layer.weightsInt8.clear();
+        layer.weightScales.clear();
+
+        if(precision_ == FP16)
+        {
+            layer.weightsFP16.resize(layer.nIn*layer.nOut);
+            std::transform(layer.weights, layer.weights + layer.nIn*layer.nOut, layer.weightsFP16.begin(), floatToHalf);
+        }
+        else if(precision_ == INT8)
+        {
+            //symmetric quantization with one scale per output node
+            layer.weightScales.assign(layer.nOut, 0.0);
+            for(int k = 0; k < layer.nIn; ++k)
+            {
+                for(int j = 0; j < layer.nOut; ++j) layer.weightScales[j] = std::max(layer.weightScales[j], std::abs(layer.weights[k*layer.nOut + j]));
+            }
+            for(auto& scale : layer.weightScales) scale = (scale > 0.0f) ? scale/127.0f : 1.0f;
+
+            layer.weightsInt8.resize(layer.nIn*layer.nOut);
+            for(int k = 0; k < layer.nIn; ++k)
+            {
+                for(int j = 0; j < layer.nOut; ++j) layer.weightsInt8[k*layer.nOut + j] = static_cast<int8_t>(std::lrint(layer.weights[k*layer.nOut + j]/layer.weightScales[j]));
+            }
+        }
+    }
+}
+
+void TTMNativeDNN::loadModel(const std::string& file)
+{
+    //File layout (all values little endian, 4 bytes each)
+    //  char[8]  magic "TTDNN\0\0\0"
+    //  uint32   version
+    //  uint32   number of layers
+    //  for each layer:
+    //    uint32 nIn, uint32 nOut, uint32 activation
+    //    float  weights[nIn*nOut]
+    //    float  biases[nOut]
+    //The file is mapped read-only so that all processes loading the same model share one copy of the weights
+    modelData_.reset(new ttUtility::MappedFile(file));
+    const char* data = modelData_->data();
+    const size_t size = modelData_->size();
+
+    size_t pos = 0;
+    auto checkSize = [&](size_t nBytes)
+    {
+        if(pos + nBytes > size)
+        {
+            THROW_TTEXCEPTION("ERROR: Model file \"" + file + "\" is truncated");
+        }
+    };
+    auto read = [&](void* dest, size_t nBytes)
+    {
+        checkSize(nBytes);
+        memcpy(dest, data + pos, nBytes);
+        pos += nBytes;
+    };
+    //all fields are 4 bytes, so the weight arrays are always aligned for float access
+    auto mapFloats = [&](size_t n)
+    {
+        checkSize(n*sizeof(float));
+        const float* ptr = reinterpret_cast<const float*>(data + pos);
+        pos += n*sizeof(float);
+        return ptr;
+    };
+
+    char magic[8];
+    uint32_t version, nLayers;
+    read(magic, sizeof(magic));
+    read(&version, sizeof(version));
+    read(&nLayers, sizeof(nLayers));
+
+    if(memcmp(magic, "TTDNN\0\0\0", sizeof(magic)) != 0 || version != 1)
+    {
+        THROW_TTEXCEPTION("ERROR: \"" + file + "\" is not a native DNN model file (version 1)");
+    }
+
+    if(nLayers == 0)
+    {
+        THROW_TTEXCEPTION("ERROR: Model file \"" + file + "\" contains no layers");
+    }
+
+    layers_.clear();
+    layers_.resize(nLayers);
+    for(auto& layer : layers_)
+    {
+        uint32_t nIn, nOut, activation;
+        read(&nIn, sizeof(nIn));
+        read(&nOut, sizeof(nOut));
+        read(&activation, sizeof(activation));
+
+        if(activation > SOFTMAX)
+        {
+            THROW_TTEXCEPTION("ERROR: Unknown activation function " + std::to_string(activation) + " in model file \"" + file + "\"");
+        }
+
+        if(&layer != &layers_.front() && static_cast<int>(nIn) != (&layer - 1)->nOut)
+        {
+            THROW_TTEXCEPTION("ERROR: Layer size mismatch in model file \"" + file + "\"");
+        }
+
+        layer.nIn = nIn;
+        layer.nOut = nOut;
+        layer.activation = static_cast<Activation>(activation);
+        layer.weights = mapFloats(nIn*nOut);
+        layer.biases = mapFloats(nOut);
+    }
+}
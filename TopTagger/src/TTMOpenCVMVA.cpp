@@ -14,8 +14,9 @@ void TTMOpenCVMVA::getParameters(const cfg::CfgDocument* cfgDoc, const std::stri
     cfg::Context commonCxt("Common");
     cfg::Context localCxt(localContextName);
 
-    discriminator_ = cfgDoc->get("discCut",      localCxt, -999.9);
-    modelFile_     = cfgDoc->get("modelFile",    localCxt, "");
+    discriminator_ = cfgDoc->get("discCut",       localCxt, -999.9);
+    modelFile_     = cfgDoc->get("modelFile",     localCxt, "");
+    NConstituents_ = cfgDoc->get("NConstituents", localCxt, 3);
 
     csvThreshold_  = cfgDoc->get("csvThreshold", localCxt, -999.9);
     bEtaCut_       = cfgDoc->get("bEtaCut",      localCxt, -999.9);
@@ -25,25 +26,8 @@ void TTMOpenCVMVA::getParameters(const cfg::CfgDocument* cfgDoc, const std::stri
     if(workingDirectory_.size()) modelFileFullPath = workingDirectory_ + "/" + modelFile_;
     else                         modelFileFullPath = modelFile_;
 
-    int iVar = 0;
-    bool keepLooping;
-    do
-    {
-        keepLooping = false;
-
-        //Get variable name
-        std::string varName = cfgDoc->get("mvaVar", iVar, localCxt, "");
-
-        //if it is a non empty string save in vector
-        if(varName.size() > 0)
-        {
-            keepLooping = true;
-
-            vars_.push_back(varName);
-        }
-        ++iVar;
-    }
-    while(keepLooping);
+    //Get variable names
+    cfgDoc->getArray("mvaVar", localCxt, vars_);
 
     treePtr_ = cv::ml::RTrees::load<cv::ml::RTrees>(modelFileFullPath);
     if(treePtr_ == nullptr || treePtr_->empty())
@@ -63,6 +47,22 @@ void TTMOpenCVMVA::getParameters(const cfg::CfgDocument* cfgDoc, const std::stri
     {
         THROW_TTEXCEPTION("Incorrect number of variables specified!!! " + std::to_string(treePtr_->getVarCount()) + "expected " + std::to_string(vars_.size()) + " found.");
     }
+
+    //load variables
+    if(NConstituents_ == 1)
+    {
+        varCalculator_.reset(new ttUtility::BDTMonojetInputCalculator());
+    }
+    else if(NConstituents_ == 2)
+    {
+        varCalculator_.reset(new ttUtility::BDTDijetInputCalculator());
+    }
+    else if(NConstituents_ == 3)
+    {
+        varCalculator_.reset(new ttUtility::TrijetInputCalculator());
+    }
+    //map variables
+    varCalculator_->mapVars(vars_);
 #else
     //Mark variables unused to suppress warnings
     (void)cfgDoc;
@@ -79,36 +79,50 @@ void TTMOpenCVMVA::run(TopTaggerResults& ttResults)
     //Get the list of final tops into which we will stick candidates
     std::vector<TopObject*>& tops = ttResults.getTops();
 
-    for(auto& topCand : topCandidates)
+    std::vector<TopObject*> validCands;
+    //Only the candidates of the type handled by the variable calculator are considered
+    for(unsigned int iCand : ttResults.getCandidatesOfType(varCalculator_->getCandType()))
     {
-        //We only want to apply the MVA algorithm to triplet tops
-        if(topCand.getNConstituents() == 3)
+        auto& topCand = topCandidates[iCand];
+
+        //Skip candidates already rejected by a prefilter module
+        if(ttResults.isRejected(topCand)) continue;
+
+        //Prepare data from top candidate (this code is shared with training tuple producer)
+        if(varCalculator_->checkCand(topCand))
         {
-            //Prepare data from top candidate (this code is shared with training tuple producer)
-            //Perhaps one day the intermediate map can be bypassed ...
-            std::map<std::string, double> varMap = ttUtility::createMVAInputs(topCand, csvThreshold_);
-
-            //Construct opencv data matrix for prediction
-            cv::Mat inputData(vars_.size(), 1, 5); //the last 5 is for CV_32F var type
-
-            //populate opencv data matrix based on desired input variables 
-            for(unsigned int i = 0; i < vars_.size(); ++i)
-            {
-                inputData.at<float>(i, 0) = varMap[vars_[i]];
-            }
-
-            //predict value
-            double discriminator = treePtr_->predict(inputData);
-            topCand.setDiscriminator(discriminator);
-
-            //Check number of b-tagged jets in the top
-            bool passBrequirements = maxNbInTop_ < 0 || topCand.getNBConstituents(csvThreshold_, bEtaCut_) <= maxNbInTop_;
-
-            //place in final top list if it passes the threshold
-            if(discriminator > discriminator_ && passBrequirements)
-            {
-                tops.push_back(&topCand);
-            }
+            validCands.emplace_back(&topCand);
+        }
+    }
+
+    if(validCands.empty()) return;
+
+    //fill the input data with one row per candidate
+    data_.resize(validCands.size() * vars_.size());
+    varCalculator_->setPtr(data_.data());
+    varCalculator_->calculateEventVars(ttResults, vars_, validCands);
+
+    //Construct opencv data matrix for prediction (this does not copy the data)
+    cv::Mat inputData(validCands.size(), vars_.size(), CV_32F, data_.data());
+
+    //predict values for all candidates at once
+    cv::Mat discriminators;
+    treePtr_->predict(inputData, discriminators);
+
+    for(unsigned int iCand = 0; iCand < validCands.size(); ++iCand)
+    {
+        auto* topCand = validCands[iCand];
+
+        double discriminator = discriminators.at<float>(iCand, 0);
+        topCand->setDiscriminator(discriminator);
+
+        //Check number of b-tagged jets in the top
+        bool passBrequirements = maxNbInTop_ < 0 || ttResults.getNBConstituents(*topCand, csvThreshold_, bEtaCut_) <= maxNbInTop_;
+
+        //place in final top list if it passes the threshold
+        if(discriminator > discriminator_ && passBrequirements)
+        {
+            tops.push_back(topCand);
         }
     }
 #else
@@ -116,3 +130,7 @@ void TTMOpenCVMVA::run(TopTaggerResults& ttResults)
     (void)ttResults;
 #endif
 }
+
+TTMOpenCVMVA::~TTMOpenCVMVA()
+{
+}
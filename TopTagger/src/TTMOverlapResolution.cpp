@@ -9,6 +9,11 @@
 #include <algorithm>
 #include <vector>
 #include <cmath>
+#include <chrono>
+
+TTMOverlapResolution::TTMOverlapResolution() : timing_{0, 0.0}
+{
+}
 
 void TTMOverlapResolution::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& localContextName)
 {
@@ -27,103 +32,104 @@ void TTMOverlapResolution::getParameters(const cfg::CfgDocument* cfgDoc, const s
     markUsed_      = cfgDoc->get("markUsed",      localCxt,  true);
 
     //select the approperiate sorting function 
-    doSort_ = true;  //sort true unless option "none" is selected
-    if(sortMethod_.compare("topMass") == 0)
-    {
-        sortFunc_ = [this](const TopObject* t1, const TopObject* t2)
-        {
-            double m1 = -999.9, m2 = -999.9;
-            const auto& constVec1 = t1->getConstituents();
-            switch(t1->getNConstituents())
-            {
-            case 3:
-                m1 = t1->p().M();
-                break;
-            case 2:
-                if(constVec1[0]->getType() == Constituent::AK8JET)
-                {
-                    TLorentzVector psudoVec;
-                    psudoVec.SetPtEtaPhiM(constVec1[0]->p().Pt(), constVec1[0]->p().Eta(), constVec1[0]->p().Phi(), constVec1[0]->getSoftDropMass() * constVec1[0]->getWMassCorr());
-                    m1 = (psudoVec + constVec1[1]->p()).M();
-                }
-                else
-                {
-                    TLorentzVector psudoVec;
-                    psudoVec.SetPtEtaPhiM(constVec1[1]->p().Pt(), constVec1[1]->p().Eta(), constVec1[1]->p().Phi(), constVec1[1]->getSoftDropMass() * constVec1[1]->getWMassCorr());
-                    m1 = (psudoVec + constVec1[0]->p()).M();
-                }
-                break;
-            case 1:
-                m1 = constVec1[0]->getSoftDropMass();
-                break;
-            }
-
-            const auto& constVec2 = t2->getConstituents();
-            switch(t2->getNConstituents())
-            {
-            case 3:
-                m2 = t2->p().M();
-                break;
-            case 2:
-                if(constVec2[0]->getType() == Constituent::AK8JET)
-                {
-                    TLorentzVector psudoVec;
-                    psudoVec.SetPtEtaPhiM(constVec2[0]->p().Pt(), constVec2[0]->p().Eta(), constVec2[0]->p().Phi(), constVec2[0]->getSoftDropMass() * constVec2[0]->getWMassCorr());
-                    m2 = (psudoVec + constVec2[1]->p()).M();
-                }
-                else
-                {
-                    TLorentzVector psudoVec;
-                    psudoVec.SetPtEtaPhiM(constVec2[1]->p().Pt(), constVec2[1]->p().Eta(), constVec2[1]->p().Phi(), constVec2[1]->getSoftDropMass() * constVec2[1]->getWMassCorr());
-                    m2 = (psudoVec + constVec2[0]->p()).M();
-                }
-                break;
-            case 1:
-                m2 = constVec2[0]->getSoftDropMass();
-                break;
-            }
-            return fabs(m1 - this->mt_) < fabs(m2 - this->mt_); 
-        };
-    }
-    else if(sortMethod_.compare("topPt") == 0)
-    {
-        sortFunc_ = [this](const TopObject* t1, const TopObject* t2){ return t1->p().Pt() > t2->p().Pt(); };
-    }
-    else if(sortMethod_.compare("mvaDisc") == 0)
+    if     (sortMethod_.compare("topMass") == 0)      sortType_ = TOPMASS;
+    else if(sortMethod_.compare("topPt") == 0)        sortType_ = TOPPT;
+    else if(sortMethod_.compare("mvaDisc") == 0)      sortType_ = MVADISC;
+    else if(sortMethod_.compare("mvaDiscWithb") == 0) sortType_ = MVADISCWITHB;
+    else if(sortMethod_.compare("none") == 0)         sortType_ = NONE;
+    else
     {
-        sortFunc_ = [this](const TopObject* t1, const TopObject* t2){ return t1->getDiscriminator() > t2->getDiscriminator(); };
+        THROW_TTEXCEPTION("Invalid sorting option");
     }
-    else if(sortMethod_.compare("mvaDiscWithb") == 0)
+
+}
+
+double TTMOverlapResolution::sortMass(const TopObject& top) const
+{
+    double m = -999.9;
+    const auto& constVec = top.getConstituents();
+    switch(top.getNConstituents())
     {
-        sortFunc_ = [this](const TopObject* t1, const TopObject* t2)
+    case 3:
+        m = top.p().M();
+        break;
+    case 2:
         {
-            int nb1 = t1->getNBConstituents(cvsThreshold_);
-            int nb2 = t2->getNBConstituents(cvsThreshold_);
-            if     (nb1 <= 1 && nb2 > 1)  return true;
-            else if(nb1 > 1  && nb2 <= 1) return false;
-            else if(nb1 <= 1 && nb2 <= 1) ; //sort by discriminator
-            else if(nb1 < nb2)            return true;
-            else if(nb1 > nb2)            return false;
-
-            if(t1->getDiscriminator() > t2->getDiscriminator()) return true; 
-
-            return false;
-        };
+            //use the corrected soft drop mass for the AK8 jet
+            const int iAK8 = (constVec[0]->getType() == Constituent::AK8JET) ? 0 : 1;
+            TLorentzVector psudoVec;
+            psudoVec.SetPtEtaPhiM(constVec[iAK8]->p().Pt(), constVec[iAK8]->p().Eta(), constVec[iAK8]->p().Phi(), constVec[iAK8]->getSoftDropMass() * constVec[iAK8]->getWMassCorr());
+            m = (psudoVec + constVec[1 - iAK8]->p()).M();
+        }
+        break;
+    case 1:
+        m = constVec[0]->getSoftDropMass();
+        break;
     }
-    else if(sortMethod_.compare("none") == 0)
+    return m;
+}
+
+void TTMOverlapResolution::sortTops(const TopTaggerResults& ttResults, std::vector<TopObject*>& tops)
+{
+    //compute the figure of merit for each top once before sorting
+    sortKeys_.resize(tops.size());
+    for(unsigned int iTop = 0; iTop < tops.size(); ++iTop)
     {
-        //do nothing 
-        doSort_ = false;
+        auto& key = sortKeys_[iTop];
+        key.top = tops[iTop];
+        key.nb = 0;
+        switch(sortType_)
+        {
+        case TOPMASS:
+            key.value = fabs(sortMass(*tops[iTop]) - mt_);
+            break;
+        case TOPPT:
+            key.value = tops[iTop]->p().Pt();
+            break;
+        case MVADISC:
+            key.value = tops[iTop]->getDiscriminator();
+            break;
+        case MVADISCWITHB:
+            key.value = tops[iTop]->getDiscriminator();
+            key.nb = ttResults.getNBConstituents(*tops[iTop], cvsThreshold_);
+            break;
+        case NONE:
+            break;
+        }
     }
-    else
+
+    switch(sortType_)
     {
-        THROW_TTEXCEPTION("Invalid sorting option");
+    case TOPMASS:
+        std::sort(sortKeys_.begin(), sortKeys_.end(), [](const SortKey& k1, const SortKey& k2){ return k1.value < k2.value; });
+        break;
+    case TOPPT:
+    case MVADISC:
+        std::sort(sortKeys_.begin(), sortKeys_.end(), [](const SortKey& k1, const SortKey& k2){ return k1.value > k2.value; });
+        break;
+    case MVADISCWITHB:
+        std::sort(sortKeys_.begin(), sortKeys_.end(), [](const SortKey& k1, const SortKey& k2)
+        {
+            if     (k1.nb <= 1 && k2.nb > 1)  return true;
+            else if(k1.nb > 1  && k2.nb <= 1) return false;
+            else if(k1.nb <= 1 && k2.nb <= 1) ; //sort by discriminator
+            else if(k1.nb < k2.nb)            return true;
+            else if(k1.nb > k2.nb)            return false;
+
+            return k1.value > k2.value;
+        });
+        break;
+    case NONE:
+        break;
     }
 
+    for(unsigned int iTop = 0; iTop < tops.size(); ++iTop) tops[iTop] = sortKeys_[iTop].top;
 }
 
 void TTMOverlapResolution::run(TopTaggerResults& ttResults)
 {
+    auto startTime = std::chrono::steady_clock::now();
+
     //Get list of constituents used to construct tops
     const std::vector< Constituent>& constituents = ttResults.getConstituents();
 
@@ -133,37 +139,54 @@ void TTMOverlapResolution::run(TopTaggerResults& ttResults)
     //This container will keep track of which jets have been included in final tops
     std::set<Constituent const *>& usedJets = ttResults.getUsedConstituents();
 
+    //Compute which constituents are covered by each AK8 jet once for the event
+    buildOverlapMatrix(constituents, dRMatch_, dRMatchAK8_);
+
+    //The used jets are tracked internally as a bitset indexed by position in the constituent list
+    usedBits_.assign((constituents.size() + 63)/64, 0);
+    for(const auto* jet : usedJets)
+    {
+        const size_t iJet = jet - constituents.data();
+        if(iJet < constituents.size()) usedBits_[iJet >> 6] |= uint64_t(1) << (iJet & 63);
+    }
+
     //Sort the top vector for overlap resolution
-    if(doSort_) std::sort(tops.begin(), tops.end(), sortFunc_);
+    if(sortType_ != NONE) sortTops(ttResults, tops);
 
-    for(auto iTop = tops.begin(); iTop != tops.end();)
+    //Mark the tops to keep and compact the vector in a single pass
+    auto iKeep = tops.begin();
+    for(auto* top : tops)
     {
         //Check that this top had the expected type
-        if((type_ == TopObject::ANY) || ((*iTop)->getType() == type_))
+        if((type_ == TopObject::ANY) || (top->getType() == type_))
         {
             //Get constituent jets for this top
-            const std::vector<Constituent const *>& jets = (*iTop)->getConstituents();
+            const std::vector<Constituent const *>& jets = top->getConstituents();
 
             //Requirement on top eta here
-            bool passTopEta = (fabs((*iTop)->p().Eta()) < maxTopEta_);
+            bool passTopEta = (fabs(top->p().Eta()) < maxTopEta_);
 
-            //Check if the candidates have been used in another top
-            bool overlaps = constituentsAreUsed(jets, usedJets, dRMatch_, dRMatchAK8_);
-
-            //Prune top from final top collection if it fails the following requirements
-            if(overlaps || !passTopEta)
-            {
-                //This is inefficient and dumb
-                iTop = tops.erase(iTop);
-                continue;
-            }
+            //Prune top from final top collection if it fails the top eta requirement or any of its candidates have been used in another top
+            if(!passTopEta || constituentsAreUsed(jets, usedBits_)) continue;
 
             //If the candidate survived, it must be a good top!!!
 
             //Add the good tops constituents to the set tracking which constituents have been used
-            if(markUsed_) markConstituentsUsed(jets, constituents, usedJets, dRMatch_, dRMatchAK8_);
+            if(markUsed_) markConstituentsUsed(jets, usedBits_);
         }
 
-        ++iTop;
+        *(iKeep++) = top;
+    }
+    tops.erase(iKeep, tops.end());
+
+    //Copy the used jets back into the set for later modules, the constituents are inserted in address order
+    for(size_t iJet = 0; iJet < constituents.size(); ++iJet)
+    {
+        if((usedBits_[iJet >> 6] >> (iJet & 63)) & 1) usedJets.insert(usedJets.end(), &constituents[iJet]);
     }
+
+    clearOverlapMatrix();
+
+    ++timing_.nEvents;
+    timing_.totalTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
 }
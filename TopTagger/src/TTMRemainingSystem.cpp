@@ -4,6 +4,9 @@
 #include "TopTagger/CfgParser/include/Context.hh"
 #include "TopTagger/CfgParser/include/CfgDocument.hh"
 
+#include <limits>
+#include <cstdint>
+
 void TTMRemainingSystem::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& localContextName)
 {
     //Construct contexts
@@ -41,8 +44,13 @@ void TTMRemainingSystem::run(TopTaggerResults& ttResults)
 
     Constituent const * seed = nullptr;
 
-    for(auto& jet : consituents)
+    //b-tag flags of the constituents, no eta requirement is applied for the seed
+    const std::vector<uint64_t>& bTagBits = ttResults.getBTagBits(CSVThresh_, std::numeric_limits<double>::infinity());
+
+    for(unsigned int iJet = 0; iJet < consituents.size(); ++iJet)
     {
+        const Constituent& jet = consituents[iJet];
+
         //check if jet is used in a top
         if(usedJets.count(&jet)) continue;
 
@@ -59,7 +67,7 @@ void TTMRemainingSystem::run(TopTaggerResults& ttResults)
         }
 
         //or better yet the first (highest pt) b-tagged jet if one exists
-        if(jet.getBTagDisc() > CSVThresh_)
+        if((bTagBits[iJet >> 6] >> (iJet & 63)) & 1)
         {
             seed = &jet;
             break;
@@ -85,8 +93,9 @@ void TTMRemainingSystem::run(TopTaggerResults& ttResults)
             //check if jet is used in a top or is the seed
             if(usedJets.count(&jet) || &jet == seed) continue;
 
-            double dR = seed->p().DeltaR(jet.p());
-            double mdijet = (seed->p() + jet.p()).M();
+            const auto& pair = ttResults.getConstituentPair(*seed, jet);
+            double dR = pair.dR;
+            double mdijet = pair.m;
 
             //select second jet based upon dR and dijet mass
             if((dRMax_  < 0 || dR < dRMax_)  //disable dR entirely if dRMax is less than 0
@@ -57,10 +57,54 @@ static std::string embeddedTensorflowScript = ""
 "    global tfw\n"
 "    tfw = TFWrapper(frozen_graph_filename)\n"
 "\n"
+"#inputs holds one row per top candidate, the whole event is evaluated in one session run\n"
+"#(tensorflow releases the GIL internally while the graph is executing)\n"
 "def eval_session_shot(inputs, outputs):\n"
 "    tfw.eval_session(inputs, outputs)\n"
+"\n"
+"def closeSession_shot():\n"
+"    global tfw\n"
+"    tfw = None\n"
 "";
+
+namespace
+{
+    //Hold the GIL for the lifetime of this object, it is also released if an exception is thrown while python is in use
+    class PyGILStateGuard
+    {
+    private:
+        PyGILState_STATE gilState_;
+
+    public:
+        PyGILStateGuard() : gilState_(PyGILState_Ensure()) {}
+
+        PyGILStateGuard(const PyGILStateGuard&) = delete;
+        PyGILStateGuard& operator=(const PyGILStateGuard&) = delete;
+
+        ~PyGILStateGuard()
+        {
+            PyGILState_Release(gilState_);
+        }
+    };
+
+    //Owning reference to a python object, it must go out of scope while the GIL is held
+    struct PyDecRef
+    {
+        void operator()(PyObject* pObj) const
+        {
+            Py_XDECREF(pObj);
+        }
+    };
+    typedef std::unique_ptr<PyObject, PyDecRef> PyObjectPtr;
+}
+#endif
+
+TTMTFPyBind::TTMTFPyBind()
+#ifdef DOPYCAPIBIND
+    : pModule_(nullptr), pGlobal_(nullptr), inputs_(nullptr), ownInterpreter_(false), threadState_(nullptr)
 #endif
+{
+}
 
 void TTMTFPyBind::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& localContextName)
 {
@@ -85,45 +129,24 @@ void TTMTFPyBind::getParameters(const cfg::CfgDocument* cfgDoc, const std::strin
     if(workingDirectory_.size()) modelFileFullPath = workingDirectory_ + "/" + modelFile_;
     else                         modelFileFullPath = modelFile_;
 
-    int iVar = 0;
-    bool keepLooping;
-    do
-    {
-        keepLooping = false;
-
-        //Get variable name
-        std::string varName = cfgDoc->get("mvaVar", iVar, localCxt, "");
-
-        //if it is a non empty string save in vector
-        if(varName.size() > 0)
-        {
-            keepLooping = true;
-
-            vars_.push_back(varName);
-        }
-        ++iVar;
-    }
-    while(keepLooping);
+    //Get variable names
+    cfgDoc->getArray("mvaVar", localCxt, vars_);
 
     initializePyInterpreter();
 
-    //create function arguements tuple
-    PyObject *pArgs = PyTuple_New(1);
-    PyTuple_SetItem(pArgs, 0, PyString_FromString(modelFileFullPath.c_str()));
-
-    //start the tensorflow session
-    callPython("initTFWrapper", pArgs);
+    {
+        PyGILStateGuard gil;
 
-    Py_DECREF(pArgs);
+        // create input feed dict, the numpy array for the input data is created for each event
+        inputs_ = PyDict_New();
 
-    //create numpy array for input data
-    npy_intp sizearray[2] = {1, static_cast<npy_intp>(vars_.size())};
-    //PyObject* nparray_ = PyArray_SimpleNewFromData(2, sizearray, NPY_FLOAT, data);
-    nparray_ = PyArray_SimpleNew(2, sizearray, NPY_FLOAT);
+        //create function arguements tuple
+        PyObjectPtr pArgs(PyTuple_New(1));
+        PyTuple_SetItem(pArgs.get(), 0, PyString_FromString(modelFileFullPath.c_str()));
 
-    // create input feed dict
-    inputs_ = PyDict_New();
-    PyDict_SetItemString(inputs_, inputOp_.c_str(), nparray_);
+        //start the tensorflow session
+        callPython("initTFWrapper", pArgs.get());
+    }
 
     //load variables
     if(NConstituents_ == 1)
@@ -140,7 +163,6 @@ void TTMTFPyBind::getParameters(const cfg::CfgDocument* cfgDoc, const std::strin
     }
     //map variables
     varCalculator_->mapVars(vars_);
-    varCalculator_->setPtr(static_cast<float*>(PyArray_GETPTR2(reinterpret_cast<PyArrayObject*>(nparray_), 0, 0)));
 
 #else
     //Mark variables unused to suppress warnings
@@ -158,53 +180,88 @@ void TTMTFPyBind::run(TopTaggerResults& ttResults)
     //Get the list of final tops into which we will stick candidates
     std::vector<TopObject*>& tops = ttResults.getTops();
 
-    // create dict of output nodes
-    PyObject *outputs = PyDict_New();
-    PyObject* outputOpName = PyString_FromString(outputOp_.c_str());
-    PyDict_SetItem(outputs, outputOpName, Py_None);
+    std::vector<TopObject*> validCands;
+    //Only the candidates of the type handled by the variable calculator are considered
+    for(unsigned int iCand : ttResults.getCandidatesOfType(varCalculator_->getCandType()))
+    {
+        auto& topCand = topCandidates[iCand];
 
-    // create arguements tuple
-    PyObject *pArgs = PyTuple_New(2);
-    PyTuple_SetItem(pArgs, 0, inputs_);
-    PyTuple_SetItem(pArgs, 1, outputs);
-    //Tuple will steal reference to inputs_, but we want it around after the tuple is destroyed
-    Py_INCREF(inputs_);
+        //Skip candidates already rejected by a prefilter module
+        if(ttResults.isRejected(topCand)) continue;
 
-    for(auto& topCand : topCandidates)
-    {
-        //Prepare data from top candidate and calculate discriminator
-        if(varCalculator_->calculateVars(topCand, 0))
+        //Prepare data from top candidate (this code is shared with training tuple producer)
+        if(varCalculator_->checkCand(topCand))
         {
-            //Run python session to network on input data
-            callPython("eval_session_shot", pArgs);
+            validCands.emplace_back(&topCand);
+        }
+    }
 
-            //Get output discriminator
-            PyObject *discriminators = PyDict_GetItem(outputs, outputOpName);
-            double discriminator = -999.9;
-            if(PyArray_Check(discriminators))
-            {
-                discriminator = static_cast<double>(*static_cast<float*>(PyArray_GETPTR2(reinterpret_cast<PyArrayObject*>(discriminators), 0, 0)));
-                topCand.setDiscriminator(discriminator);
-            }
-            else
-            {
-                THROW_TTEXCEPTION("Returned object is not a numpy array!!!");
-            }
+    if(validCands.empty()) return;
 
-            //Check number of b-tagged jets in the top
-            bool passBrequirements = maxNbInTop_ < 0 || topCand.getNBConstituents(csvThreshold_, bEtaCut_) <= maxNbInTop_;
+    //Prepare data from top candidates, this is done before taking the GIL so that taggers in different threads calculate their inputs in parallel
+    inputBuf_.resize(validCands.size() * vars_.size());
+    varCalculator_->setPtr(inputBuf_.data());
+    varCalculator_->calculateEventVars(ttResults, vars_, validCands);
 
-            //place in final top list if it passes the threshold
-            if(discriminator > std::min(discriminator_, discOffset_ + topCand.p().Pt()*discSlope_) && passBrequirements)
-            {
-                tops.push_back(&topCand);
-            }
+    if(validCands.empty()) return;
+
+    std::vector<double> discriminators(validCands.size());
+    {
+        //only hold the GIL while we are working with python objects, the references below are released before the GIL
+        PyGILStateGuard gil;
+
+        //create numpy array for input data with one row per candidate
+        npy_intp sizearray[2] = {static_cast<npy_intp>(validCands.size()), static_cast<npy_intp>(vars_.size())};
+        PyObjectPtr nparray(PyArray_SimpleNew(2, sizearray, NPY_FLOAT));
+        memcpy(PyArray_DATA(reinterpret_cast<PyArrayObject*>(nparray.get())), inputBuf_.data(), validCands.size() * vars_.size() * sizeof(float));
+        PyDict_SetItemString(inputs_, inputOp_.c_str(), nparray.get());
+
+        // create dict of output nodes
+        PyObjectPtr outputs(PyDict_New());
+        PyObjectPtr outputOpName(PyString_FromString(outputOp_.c_str()));
+        PyDict_SetItem(outputs.get(), outputOpName.get(), Py_None);
+
+        // create arguements tuple
+        //Tuple will steal reference to inputs_ and outputs, but we want them around after the tuple is destroyed
+        PyObjectPtr pArgs(PyTuple_New(2));
+        Py_INCREF(inputs_);
+        Py_INCREF(outputs.get());
+        PyTuple_SetItem(pArgs.get(), 0, inputs_);
+        PyTuple_SetItem(pArgs.get(), 1, outputs.get());
+
+        //Run python session to evaluate network on all candidates at once
+        callPython("eval_session_shot", pArgs.get());
+
+        //Get output discriminators
+        PyObject *pDiscriminators = PyDict_GetItem(outputs.get(), outputOpName.get());
+        if(!pDiscriminators || !PyArray_Check(pDiscriminators))
+        {
+            THROW_TTEXCEPTION("Returned object is not a numpy array!!!");
+        }
+
+        //discriminators is a 2D array, we only want the first entry of every array
+        for(unsigned int iCand = 0; iCand < validCands.size(); ++iCand)
+        {
+            discriminators[iCand] = static_cast<double>(*static_cast<float*>(PyArray_GETPTR2(reinterpret_cast<PyArrayObject*>(pDiscriminators), iCand, 0)));
         }
     }
 
-    Py_DECREF(outputs);
-    Py_DECREF(outputOpName);
-    Py_DECREF(pArgs);
+    for(unsigned int iCand = 0; iCand < validCands.size(); ++iCand)
+    {
+        auto* topCand = validCands[iCand];
+
+        double discriminator = discriminators[iCand];
+        topCand->setDiscriminator(discriminator);
+
+        //Check number of b-tagged jets in the top
+        bool passBrequirements = maxNbInTop_ < 0 || ttResults.getNBConstituents(*topCand, csvThreshold_, bEtaCut_) <= maxNbInTop_;
+
+        //place in final top list if it passes the threshold
+        if(discriminator > std::min(discriminator_, discOffset_ + topCand->p().Pt()*discSlope_) && passBrequirements)
+        {
+            tops.push_back(topCand);
+        }
+    }
 
 #else
     //Mark variables unused to suppress warnings
@@ -215,18 +272,29 @@ void TTMTFPyBind::run(TopTaggerResults& ttResults)
 TTMTFPyBind::~TTMTFPyBind()
 {
 #ifdef DOPYCAPIBIND
-    //close the tensorflow session 
-    PyObject *pArgs = PyTuple_New(0);
-    callPython("closeSession_shot", pArgs);
-    Py_DECREF(pArgs);
-
-    //finish cleanup of python objects and close interpreter
-    Py_DECREF(inputs_);
-    Py_DECREF(nparray_);
-    Py_DECREF(pModule_);
-    Py_DECREF(pMain_);
-    Py_DECREF(pGlobal_);
-    Py_Finalize();
+    //reacquire the GIL before cleaning up, an interpreter owned by the host program (e.g. the python interface) is left running
+    if(ownInterpreter_) PyEval_RestoreThread(threadState_);
+    if(Py_IsInitialized())
+    {
+        PyGILStateGuard gil;
+
+        //close the tensorflow session, a destructor must not throw
+        if(pModule_)
+        {
+            PyObjectPtr pArgs(PyTuple_New(0));
+            try
+            {
+                callPython("closeSession_shot", pArgs.get());
+            }
+            catch(const TTException&) {}
+        }
+
+        //finish cleanup of python objects, these may be missing if the configuration failed
+        Py_XDECREF(inputs_);
+        Py_XDECREF(pModule_);
+        Py_XDECREF(pGlobal_);
+    }
+    if(ownInterpreter_) Py_Finalize();
 #endif
 }
 
@@ -235,27 +303,28 @@ TTMTFPyBind::~TTMTFPyBind()
 void TTMTFPyBind::initializePyInterpreter()
 {
     // initialize the python interpreter
-    if(!Py_IsInitialized())
+    threadState_ = nullptr;
+    ownInterpreter_ = !Py_IsInitialized();
+    if(ownInterpreter_)
     {
-        PyEval_InitThreads();
         Py_Initialize();
+        PyEval_InitThreads();
+
+        //release the GIL held since Py_Initialize so python is only locked while this module is calling into it
+        threadState_ = PyEval_SaveThread();
     }
 
-    // create the main module
-    pMain_ = PyImport_AddModule("__main__");
+    PyGILStateGuard gil;
+
+    // create a private global namespace for this module, every instance has its own tensorflow wrapper and the host's __main__ is left untouched
+    pGlobal_ = PyDict_New();
 
-    if(!pMain_)
+    if(!pGlobal_ || PyDict_SetItemString(pGlobal_, "__builtins__", PyEval_GetBuiltins()) != 0)
     {
         PyErr_Print();
-        THROW_TTEXCEPTION("AddModule failed!!!");
+        THROW_TTEXCEPTION("Creating the python namespace failed!!!");
     }
 
-    // define the globals of the main module as our context
-    pGlobal_ = PyModule_GetDict(pMain_);
-
-    // since PyModule_GetDict returns a borrowed reference, increase the count to own one
-    Py_INCREF(pGlobal_);
-
     // load the python interface module
     pModule_ = PyRun_String(embeddedTensorflowScript.c_str(), Py_file_input, pGlobal_, pGlobal_);
 
@@ -264,7 +333,7 @@ void TTMTFPyBind::initializePyInterpreter()
 
     if(!pModule_)
     {
-        Py_DECREF(pMain_);
+        //the references held are released by the destructor
         PyErr_Print();
         THROW_TTEXCEPTION("PyRun_String failed!!!");        
     }
@@ -272,9 +341,9 @@ void TTMTFPyBind::initializePyInterpreter()
 
 PyObject* TTMTFPyBind::callPython(const std::string& func, PyObject* pArgs)
 {
-    if (pModule_ != NULL && pMain_ != NULL)
+    if (pModule_ != NULL && pGlobal_ != NULL)
     {
-        PyObject* pFunc = PyObject_GetAttrString(pMain_, func.c_str());
+        PyObject* pFunc = PyMapping_GetItemString(pGlobal_, func.c_str());
         // pFunc is a new reference
 
         if (pFunc && PyCallable_Check(pFunc))
@@ -288,20 +357,18 @@ PyObject* TTMTFPyBind::callPython(const std::string& func, PyObject* pArgs)
             else
             {
                 Py_DECREF(pFunc);
-                Py_DECREF(pModule_);
-                Py_DECREF(pMain_);
                 PyErr_Print();
                 THROW_TTEXCEPTION("Cannot call function \"" + func + "\"!!!");
             }
         }
         else
         {
+            Py_XDECREF(pFunc);
             if (PyErr_Occurred())
                 PyErr_Print();
             THROW_TTEXCEPTION("Cannot find function \"" + func + "\"!!!");
         }
         Py_XDECREF(pFunc);
-        Py_DECREF(pModule_);
     }
     else
     {
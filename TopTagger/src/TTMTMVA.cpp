@@ -7,6 +7,13 @@
 #include "TopTagger/CfgParser/include/CfgDocument.hh"
 #include "TopTagger/CfgParser/include/TTException.h"
 
+#include <thread>
+#include <algorithm>
+
+#ifdef SHOTTOPTAGGER_DO_TMVA
+#include "TROOT.h"
+#endif
+
 void TTMTMVA::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& localContextName)
 {
 #ifdef SHOTTOPTAGGER_DO_TMVA
@@ -19,63 +26,26 @@ void TTMTMVA::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& l
     modelName_     = cfgDoc->get("modelName",     localCxt, "");
     NConstituents_ = cfgDoc->get("NConstituents", localCxt, 3);
     filter_        = cfgDoc->get("filter",        localCxt, false);
+    nThreads_      = cfgDoc->get("NThreads",      localCxt, 1);
 
     std::string modelFileFullPath;
     if(workingDirectory_.size()) modelFileFullPath = workingDirectory_ + "/" + modelFile_;
     else                         modelFileFullPath = modelFile_;
 
-    int iVar = 0;
-    bool keepLooping;
-    do
-    {
-        keepLooping = false;
-
-        //Get variable name
-        std::string varName = cfgDoc->get("mvaVarMappedName", iVar, localCxt, "");
-
-        //if it is a non empty string save in vector
-        if(varName.size() > 0)
-        {
-            keepLooping = true;
-
-            varsTMVA_.push_back(varName);
-        }
-        ++iVar;
-    }
-    while(keepLooping);
-
-    bool varsTMVASet = varsTMVA_.size() > 0;
+    //Get variable names, the names used in the TMVA weight file default to the tagger variable names
+    cfgDoc->getArray("mvaVarMappedName", localCxt, varsTMVA_);
+    cfgDoc->getArray("mvaVar", localCxt, vars_);
+    if(varsTMVA_.empty()) varsTMVA_ = vars_;
 
-    iVar = 0;
-    do
+    if(nThreads_ < 1)
     {
-        keepLooping = false;
-
-        //Get variable name
-        std::string varName = cfgDoc->get("mvaVar", iVar, localCxt, "");
-
-        //if it is a non empty string save in vector
-        if(varName.size() > 0)
-        {
-            keepLooping = true;
-
-            vars_.push_back(varName);
-            if(!varsTMVASet) varsTMVA_.push_back(varName);
-        }
-        ++iVar;
+        THROW_TTEXCEPTION("NThreads must be at least 1!!!");
     }
-    while(keepLooping);
 
-    //create TMVA reader
-    reader_.reset(new TMVA::Reader( "!Color:!Silent" ));
-    if(reader_ == nullptr)
-    {
-        //Throw if this is an invalid pointer
-        THROW_TTEXCEPTION("TMVA reader creation failed!!!");
-    }
+    //ROOT must be told that it will be used from multiple threads
+    if(nThreads_ > 1) ROOT::EnableThreadSafety();
 
     //load variables
-    varMap_.resize(vars_.size());
     if(NConstituents_ == 1)
     {
         varCalculator_.reset(new ttUtility::BDTMonojetInputCalculator());
@@ -89,20 +59,34 @@ void TTMTMVA::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& l
         varCalculator_.reset(new ttUtility::TrijetInputCalculator());
     }
     varCalculator_->mapVars(vars_);
-    varCalculator_->setPtr(varMap_.data());
 
-    //load variables into reader
-    for(unsigned int i = 0; i < vars_.size(); ++i)
+    //create one TMVA reader for each thread as the readers cannot be shared
+    varMaps_.resize(nThreads_, std::vector<float>(vars_.size()));
+    for(int iThread = 0; iThread < nThreads_; ++iThread)
     {
-        reader_->AddVariable(varsTMVA_[i].c_str(), &varMap_[i]);
-    }
+        readers_.emplace_back(new TMVA::Reader( "!Color:!Silent" ));
+        if(readers_.back() == nullptr)
+        {
+            //Throw if this is an invalid pointer
+            THROW_TTEXCEPTION("TMVA reader creation failed!!!");
+        }
 
-    //load model file into reader
-    auto* imethod = reader_->BookMVA( modelName_.c_str(), modelFileFullPath.c_str() );
-    if(imethod == nullptr)
-    {
-        //Throw if this is an invalid pointer
-        THROW_TTEXCEPTION("TMVA reader could not load model named \"" + modelName_ + "\" from file \"" + modelFileFullPath + "\"!!!");        
+        //load variables into reader
+        for(unsigned int i = 0; i < vars_.size(); ++i)
+        {
+            readers_.back()->AddVariable(varsTMVA_[i].c_str(), &varMaps_[iThread][i]);
+        }
+
+        //load model file into reader
+        auto* imethod = readers_.back()->BookMVA( modelName_.c_str(), modelFileFullPath.c_str() );
+        if(imethod == nullptr)
+        {
+            //Throw if this is an invalid pointer
+            THROW_TTEXCEPTION("TMVA reader could not load model named \"" + modelName_ + "\" from file \"" + modelFileFullPath + "\"!!!");        
+        }
+
+        //keep the method pointer so we avoid looking it up by name for every candidate
+        methods_.push_back(dynamic_cast<TMVA::MethodBase*>(imethod));
     }
 
 #else
@@ -121,30 +105,85 @@ void TTMTMVA::run(TopTaggerResults& ttResults)
     //Get the list of final tops into which we will stick candidates
     std::vector<TopObject*>& tops = ttResults.getTops();
 
-    for(auto& topCand : topCandidates)
+    //In filter mode candidates which fail the selection are marked and removed from the top list in one pass
+    std::vector<char> failed(filter_ ? topCandidates.size() : 0, false);
+    auto removeFailed = [&]()
     {
-        //Prepare data from top candidate and calculate discriminators 
-        if(varCalculator_->calculateVars(topCand, 0))
+        tops.erase(std::remove_if(tops.begin(), tops.end(), [&](const TopObject* top)
+                                  {
+                                      const auto iTop = top - topCandidates.data();
+                                      return iTop >= 0 && iTop < static_cast<long>(failed.size()) && failed[iTop];
+                                  }), tops.end());
+    };
+
+    std::vector<TopObject*> validCands;
+    //Only the candidates of the type handled by the variable calculator are considered
+    for(unsigned int iCand : ttResults.getCandidatesOfType(varCalculator_->getCandType()))
+    {
+        auto& topCand = topCandidates[iCand];
+
+        //Skip candidates already rejected by a prefilter module, in filter mode they fail the selection
+        if(ttResults.isRejected(topCand))
         {
-            //predict value
-            double discriminator = reader_->EvaluateMVA(modelName_);
-            topCand.setDiscriminator(discriminator);
+            if(filter_) failed[iCand] = true;
+            continue;
+        }
 
-            //place in final top list if it passes the threshold
-            if(filter_)
-            {
-                if(discriminator <= discriminator_)
-                {
-                    auto iTop = std::find(tops.begin(), tops.end(), &topCand);
-                    if(iTop != tops.end()) tops.erase(iTop);
-                }
-            }
-            else
+        //Prepare data from top candidate (this code is shared with training tuple producer)
+        if(varCalculator_->checkCand(topCand))
+        {
+            validCands.emplace_back(&topCand);
+        }
+    }
+
+    if(validCands.empty())
+    {
+        if(filter_) removeFailed();
+        return;
+    }
+
+    //calculate the input variables for all candidates
+    data_.resize(validCands.size() * vars_.size());
+    varCalculator_->setPtr(data_.data());
+    varCalculator_->calculateEventVars(ttResults, vars_, validCands);
+
+    //calculate discriminators, splitting the candidates between threads if requested
+    //each thread needs enough work to be worth the cost of starting it
+    const unsigned int minCandPerThread = 32;
+    const unsigned int nThreads = std::max(1u, std::min(static_cast<unsigned int>(nThreads_), static_cast<unsigned int>(validCands.size())/minCandPerThread));
+    if(nThreads == 1)
+    {
+        evaluate(0, validCands, 0, validCands.size());
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+        const unsigned int nPerThread = (validCands.size() + nThreads - 1)/nThreads;
+        for(unsigned int iThread = 1; iThread < nThreads; ++iThread)
+        {
+            threads.emplace_back(&TTMTMVA::evaluate, this, iThread, std::cref(validCands), iThread*nPerThread, std::min(static_cast<unsigned int>(validCands.size()), (iThread + 1)*nPerThread));
+        }
+        evaluate(0, validCands, 0, nPerThread);
+        for(auto& thread : threads) thread.join();
+    }
+
+    //place in final top list if it passes the threshold
+    if(filter_)
+    {
+        for(auto* topCand : validCands)
+        {
+            if(topCand->getDiscriminator() <= discriminator_) failed[topCand - topCandidates.data()] = true;
+        }
+
+        removeFailed();
+    }
+    else
+    {
+        for(auto* topCand : validCands)
+        {
+            if(topCand->getDiscriminator() > discriminator_)
             {
-                if(discriminator > discriminator_)
-                {
-                    tops.push_back(&topCand);
-                }
+                tops.push_back(topCand);
             }
         }
     }
@@ -153,3 +192,25 @@ void TTMTMVA::run(TopTaggerResults& ttResults)
     (void)ttResults;
 #endif
 }
+
+TTMTMVA::~TTMTMVA()
+{
+}
+
+#ifdef SHOTTOPTAGGER_DO_TMVA
+
+void TTMTMVA::evaluate(const unsigned int iReader, const std::vector<TopObject*>& cands, const unsigned int first, const unsigned int last)
+{
+    std::vector<float>& varMap = varMaps_[iReader];
+    for(unsigned int iCand = first; iCand < last; ++iCand)
+    {
+        //copy this candidate's variables into the reader's inputs
+        const float* start = data_.data() + iCand*vars_.size();
+        std::copy(start, start + vars_.size(), varMap.begin());
+
+        //predict value
+        cands[iCand]->setDiscriminator(readers_[iReader]->EvaluateMVA(methods_[iReader]));
+    }
+}
+
+#endif
@@ -35,31 +35,17 @@ void TTMTensorflow::getParameters(const cfg::CfgDocument* cfgDoc, const std::str
     if(workingDirectory_.size()) modelFileFullPath = workingDirectory_ + "/" + modelFile_;
     else                         modelFileFullPath = modelFile_;
 
-    int iVar = 0;
-    bool keepLooping;
-    do
-    {
-        keepLooping = false;
-
-        //Get variable name
-        std::string varName = cfgDoc->get("mvaVar", iVar, localCxt, "");
-
-        //if it is a non empty string save in vector
-        if(varName.size() > 0)
-        {
-            keepLooping = true;
-
-            vars_.push_back(varName);
-        }
-        ++iVar;
-    }
-    while(keepLooping);
+    //Get variable names
+    cfgDoc->getArray("mvaVar", localCxt, vars_);
 
     //Variable to hold tensorflow status
     TF_Status* status = TF_NewStatus();
 
-    //get the grafdef from the file
-    TF_Buffer* graph_def = read_file(modelFileFullPath);
+    //get the grafdef from the file, the file is mapped read-only and the buffer only borrows the mapped memory
+    ttUtility::MappedFile graphFile(modelFileFullPath);
+    TF_Buffer* graph_def = TF_NewBuffer();
+    graph_def->data = graphFile.data();
+    graph_def->length = graphFile.size();
 
     // Import graph_def into graph
     TF_Graph* graph = TF_NewGraph();
@@ -142,8 +128,14 @@ void TTMTensorflow::run(TopTaggerResults& ttResults)
 
 
     std::vector<TopObject*> validCands;
-    for(auto& topCand : topCandidates)
+    //Only the candidates of the type handled by the variable calculator are considered
+    for(unsigned int iCand : ttResults.getCandidatesOfType(varCalculator_->getCandType()))
     {
+        auto& topCand = topCandidates[iCand];
+
+        //Skip candidates already rejected by a prefilter module
+        if(ttResults.isRejected(topCand)) continue;
+
         //Prepare data from top candidate (this code is shared with training tuple producer)
         if(varCalculator_->checkCand(topCand))
         {
@@ -169,18 +161,14 @@ void TTMTensorflow::run(TopTaggerResults& ttResults)
     varCalculator_->setPtr(static_cast<float*>(TF_TensorData(input_values_0)));
 
     //Prepare data from top candidate (this code is shared with training tuple producer)
-    unsigned int iCand = 0;
-    for(auto& topCand : validCands)
+    varCalculator_->calculateEventVars(ttResults, vars_, validCands);
+    if(saveInputs_)
     {
-        if(varCalculator_->calculateVars(*topCand, iCand))
+        for(unsigned int iCand = 0; iCand < validCands.size(); ++iCand)
         {
-            if(saveInputs_)
-            {
-                float *start = static_cast<float*>(TF_TensorData(input_values_0)) + vars_.size() * iCand;
-                float *end = start + vars_.size();
-                topCand->storeMVAInputs(vars_, start, end);
-            }
-            ++iCand;
+            float *start = static_cast<float*>(TF_TensorData(input_values_0)) + vars_.size() * iCand;
+            float *end = start + vars_.size();
+            validCands[iCand]->storeMVAInputs(vars_, start, end);
         }
     }
 
@@ -207,7 +195,7 @@ void TTMTensorflow::run(TopTaggerResults& ttResults)
 
     //Get output discriminators 
     auto discriminators = static_cast<float*>(TF_TensorData(output_values[0]));                
-    for(iCand = 0; iCand < validCands.size(); ++iCand)
+    for(unsigned int iCand = 0; iCand < validCands.size(); ++iCand)
     {
         auto* topCand = validCands[iCand];
         
@@ -216,7 +204,7 @@ void TTMTensorflow::run(TopTaggerResults& ttResults)
         topCand->setDiscriminator(discriminator);
         
         //Check number of b-tagged jets in the top
-        bool passBrequirements = maxNbInTop_ < 0 || topCand->getNBConstituents(csvThreshold_, bEtaCut_) <= maxNbInTop_;
+        bool passBrequirements = maxNbInTop_ < 0 || ttResults.getNBConstituents(*topCand, csvThreshold_, bEtaCut_) <= maxNbInTop_;
         
         //place in final top list if it passes the threshold
         if(discriminator > std::min(discriminator_, discOffset_ + topCand->p().Pt()*discSlope_) && passBrequirements)
@@ -251,43 +239,3 @@ TTMTensorflow::~TTMTensorflow()
     TF_DeleteStatus(status);
 #endif
 }
-
-#ifdef DOTENSORFLOW
-
-void free_buffer(void* data, size_t length) 
-{
-    //mark length as unused
-    (void)length;
-    //free the memory
-    free(data);
-}
-
-TF_Buffer* TTMTensorflow::read_file(const std::string& file) 
-{
-    std::string fname=file;
-    ttUtility::autoExpandEnvironmentVariables(fname);
-    FILE *f = fopen(fname.c_str(), "rb");
-
-    if(f == nullptr)
-    {
-        THROW_TTEXCEPTION("File not found: \"" + file + "\"");
-    }
-
-    fseek(f, 0, SEEK_END);
-    long fsize = ftell(f);
-    fseek(f, 0, SEEK_SET);  //same as rewind(f);
-
-    void* data = malloc(fsize);
-    size_t nbRead = fread(data, fsize, 1, f);
-    fclose(f);
-
-    //Check that something was read 
-    if(nbRead <= 0) return nullptr;
-
-    TF_Buffer* buf = TF_NewBuffer();
-    buf->data = data;
-    buf->length = fsize;
-    buf->data_deallocator = free_buffer;
-    return buf;
-}
-#endif
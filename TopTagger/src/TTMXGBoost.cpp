@@ -12,6 +12,15 @@
 #include <cstring>
 #include <memory>
 #include <vector>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#ifdef DOXGBOOST
+//inputs with this value are treated as missing by xgboost
+static const float MISSING = -1.0;
+#endif
 
 void TTMXGBoost::getParameters(const cfg::CfgDocument* cfgDoc, const std::string& localContextName)
 {
@@ -24,6 +33,7 @@ void TTMXGBoost::getParameters(const cfg::CfgDocument* cfgDoc, const std::string
     modelFile_     = cfgDoc->get("modelFile",     localCxt, "");
     NConstituents_ = cfgDoc->get("NConstituents", localCxt, 3);
     nCores_        = cfgDoc->get("NCores",        localCxt, 1);
+    earlyExit_     = cfgDoc->get("earlyExit",     localCxt, false);
 
     csvThreshold_  = cfgDoc->get("csvThreshold", localCxt, -999.9);
     bEtaCut_       = cfgDoc->get("bEtaCut",      localCxt, -999.9);
@@ -33,32 +43,22 @@ void TTMXGBoost::getParameters(const cfg::CfgDocument* cfgDoc, const std::string
     if(workingDirectory_.size()) modelFileFullPath = workingDirectory_ + "/" + modelFile_;
     else                         modelFileFullPath = modelFile_;
 
-    int iVar = 0;
-    bool keepLooping;
-    do
-    {
-        keepLooping = false;
-
-        //Get variable name
-        std::string varName = cfgDoc->get("mvaVar", iVar, localCxt, "");
-
-        //if it is a non empty string save in vector
-        if(varName.size() > 0)
-        {
-            keepLooping = true;
-
-            vars_.push_back(varName);
-        }
-        ++iVar;
-    }
-    while(keepLooping);
+    //Get variable names
+    cfgDoc->getArray("mvaVar", localCxt, vars_);
 
     //Variable to hold xgboost status
     int status = 0;
 
-    //get the booster from the file
+    //get the booster from the file, the file is mapped read-only and parsed in place
     status =  XGBoosterCreate({}, 0, &h_booster);
-    status |= XGBoosterLoadModel(h_booster, modelFileFullPath.c_str());
+    {
+        ttUtility::MappedFile modelData(modelFileFullPath);
+        if(XGBoosterLoadModelFromBuffer(h_booster, modelData.data(), modelData.size()))
+        {
+            //older xgboost versions can only read some model formats from a file
+            status |= XGBoosterLoadModel(h_booster, modelFileFullPath.c_str());
+        }
+    }
     status |= XGBoosterSetParam(h_booster, "nthread", std::to_string(nCores_).c_str());
 
     if(status) 
@@ -85,6 +85,9 @@ void TTMXGBoost::getParameters(const cfg::CfgDocument* cfgDoc, const std::string
     varCalculator_->mapVars(vars_);
     varCalculator_->setPtr(data_.data());
 
+    //prepare the native trees for the early exit
+    if(earlyExit_) loadTrees();
+
 #else
     //Mark variables unused to suppress warnings
     (void)cfgDoc;
@@ -101,41 +104,32 @@ void TTMXGBoost::run(TopTaggerResults& ttResults)
     //Get the list of final tops into which we will stick candidates
     std::vector<TopObject*>& tops = ttResults.getTops();
 
-    //xgboost status variable
-    int status = 0;
+    varCalculator_->setEventResults(ttResults);
 
-    for(auto& topCand : topCandidates)
+    //Only the candidates of the type handled by the variable calculator are considered
+    for(unsigned int iCand : ttResults.getCandidatesOfType(varCalculator_->getCandType()))
     {
+        auto& topCand = topCandidates[iCand];
+
+        //Skip candidates already rejected by a prefilter module
+        if(ttResults.isRejected(topCand)) continue;
+
         //Prepare the data!
         if(varCalculator_->calculateVars(topCand, 0))
         {
-            // convert to DMatrix (is this unnecessary deep copy necessary?)
-            DMatrixHandle h_data;
-            status = XGDMatrixCreateFromMat(data_.data(), 1, data_.size(), -1, &h_data);
-
-            //predict value
-            bst_ulong out_len;
-            const float *output;
-            status = XGBoosterPredict(h_booster, h_data, 0,0, &out_len, &output);
-
-            if(status)
-            {
-                THROW_TTEXCEPTION("ERROR: Unable to run booster");
-            }
-
-            if(out_len < 1)
+            //Skip the full evaluation if the candidate can no longer pass the threshold
+            double discUpperBound;
+            if(earlyExit_ && rejectEarly(data_.data(), discUpperBound))
             {
-                THROW_TTEXCEPTION("ERROR: Booster produced no output");
+                topCand.setDiscriminator(discUpperBound);
+                continue;
             }
 
-            //clean up DMatrix
-            XGDMatrixFree(h_data);
-
             //Get output discriminator 
-            topCand.setDiscriminator(output[0]);
+            topCand.setDiscriminator(predict(data_.data(), 0));
             
             //Check number of b-tagged jets in the top
-            bool passBrequirements = maxNbInTop_ < 0 || topCand.getNBConstituents(csvThreshold_, bEtaCut_) <= maxNbInTop_;
+            bool passBrequirements = maxNbInTop_ < 0 || ttResults.getNBConstituents(topCand, csvThreshold_, bEtaCut_) <= maxNbInTop_;
 
             //place in final top list if it passes the threshold
             if(topCand.getDiscriminator() > discriminator_ && passBrequirements)
@@ -159,4 +153,181 @@ TTMXGBoost::~TTMXGBoost()
 #endif
 }
 
+#ifdef DOXGBOOST
+float TTMXGBoost::predict(const float* data, int optionMask)
+{
+    // convert to DMatrix (is this unnecessary deep copy necessary?)
+    DMatrixHandle h_data;
+    int status = XGDMatrixCreateFromMat(data, 1, vars_.size(), MISSING, &h_data);
+
+    //predict value
+    bst_ulong out_len;
+    const float *output;
+    status |= XGBoosterPredict(h_booster, h_data, optionMask, 0, &out_len, &output);
+
+    if(status)
+    {
+        THROW_TTEXCEPTION("ERROR: Unable to run booster");
+    }
+
+    if(out_len < 1)
+    {
+        THROW_TTEXCEPTION("ERROR: Booster produced no output");
+    }
+
+    //copy the result before the DMatrix is freed
+    float result = output[0];
+
+    //clean up DMatrix
+    XGDMatrixFree(h_data);
+
+    return result;
+}
+
+void TTMXGBoost::loadTrees()
+{
+    //Parse the text dump of the trees, split nodes look like "0:[f2<2.45] yes=1,no=2,missing=1" and leaves like "1:leaf=0.43"
+    bst_ulong nTrees;
+    const char** dump;
+    if(XGBoosterDumpModel(h_booster, "", 0, &nTrees, &dump))
+    {
+        THROW_TTEXCEPTION("ERROR: Unable to dump the trees of model: " + modelFile_);
+    }
+
+    trees_.clear();
+    for(bst_ulong iTree = 0; iTree < nTrees; ++iTree)
+    {
+        Tree tree;
+        tree.minLeaf = std::numeric_limits<float>::max();
+        tree.maxLeaf = std::numeric_limits<float>::lowest();
+
+        std::istringstream lines(dump[iTree]);
+        std::string line;
+        while(std::getline(lines, line))
+        {
+            if(line.find_first_not_of(" \t") == std::string::npos) continue;
+
+            TreeNode node = {-1, 0.0, -1, -1, -1, 0.0};
+            int id = -1;
+            if(sscanf(line.c_str(), " %d:leaf=%f", &id, &node.leaf) == 2)
+            {
+                tree.minLeaf = std::min(tree.minLeaf, node.leaf);
+                tree.maxLeaf = std::max(tree.maxLeaf, node.leaf);
+            }
+            else if(sscanf(line.c_str(), " %d:[f%d<%f] yes=%d,no=%d,missing=%d", &id, &node.feature, &node.threshold, &node.yes, &node.no, &node.missing) != 6 || node.feature >= static_cast<int>(vars_.size()))
+            {
+                THROW_TTEXCEPTION("ERROR: earlyExit does not support the tree node \"" + line + "\" in model: " + modelFile_);
+            }
 
+            if(id < 0)
+            {
+                THROW_TTEXCEPTION("ERROR: Invalid tree node \"" + line + "\" in model: " + modelFile_);
+            }
+            if(id >= static_cast<int>(tree.nodes.size())) tree.nodes.resize(id + 1, {-1, 0.0, -1, -1, -1, 0.0});
+            tree.nodes[id] = node;
+        }
+
+        //check that all children exist
+        const int nNodes = tree.nodes.size();
+        for(const auto& node : tree.nodes)
+        {
+            if(node.feature >= 0 && (node.yes < 0 || node.yes >= nNodes || node.no < 0 || node.no >= nNodes || node.missing < 0 || node.missing >= nNodes))
+            {
+                THROW_TTEXCEPTION("ERROR: Malformed tree " + std::to_string(iTree) + " in model: " + modelFile_);
+            }
+        }
+        if(tree.nodes.empty()) continue;
+
+        trees_.push_back(std::move(tree));
+    }
+
+    //The trees with the largest spread in leaf values are evaluated first as they constrain the sum the most
+    std::stable_sort(trees_.begin(), trees_.end(), [](const Tree& t1, const Tree& t2){ return t1.maxLeaf - t1.minLeaf > t2.maxLeaf - t2.minLeaf; });
+
+    remainingMax_.assign(trees_.size() + 1, 0.0);
+    for(int iTree = trees_.size() - 1; iTree >= 0; --iTree) remainingMax_[iTree] = remainingMax_[iTree + 1] + trees_[iTree].maxLeaf;
+
+    //The base score and the output transformation are not part of the dump, get them by comparing to xgboost for one input
+    std::vector<float> zeros(vars_.size(), 0.0);
+    const double margin = predict(zeros.data(), 1);
+    const double output = predict(zeros.data(), 0);
+    marginOffset_ = margin;
+    for(const auto& tree : trees_) marginOffset_ -= evaluateTree(tree, zeros.data());
+
+    logistic_ = std::abs(output - 1.0/(1.0 + std::exp(-margin))) < 1e-5;
+    if(!logistic_ && std::abs(output - margin) > 1e-5)
+    {
+        THROW_TTEXCEPTION("ERROR: earlyExit only supports logistic or identity outputs, model: " + modelFile_);
+    }
+
+    //the dumped leaf values are rounded, allow for the accumulated rounding error and the different order of summation in xgboost
+    marginTolerance_ = 1e-4*(1.0 + std::abs(marginOffset_));
+    for(const auto& tree : trees_) marginTolerance_ += 1e-5*std::max(std::abs(tree.minLeaf), std::abs(tree.maxLeaf));
+
+    if(logistic_)
+    {
+        //every candidate passes or fails a cut outside of (0, 1) regardless of the trees
+        if(discriminator_ <= 0.0 || discriminator_ >= 1.0) earlyExit_ = false;
+        else marginThreshold_ = std::log(discriminator_/(1.0 - discriminator_));
+    }
+    else
+    {
+        marginThreshold_ = discriminator_;
+    }
+}
+
+float TTMXGBoost::evaluateTree(const Tree& tree, const float* data) const
+{
+    const TreeNode* node = &tree.nodes[0];
+    while(node->feature >= 0)
+    {
+        const float value = data[node->feature];
+        if(std::isnan(value) || value == MISSING) node = &tree.nodes[node->missing];
+        else if(value < node->threshold)          node = &tree.nodes[node->yes];
+        else                                      node = &tree.nodes[node->no];
+    }
+    return node->leaf;
+}
+
+float TTMXGBoost::maxReachableLeaf(const Tree& tree, int iNode, const float* data) const
+{
+    //Same as evaluateTree, but the dumped thresholds are rounded so both branches are followed if the input is too close to the threshold
+    const TreeNode* node = &tree.nodes[iNode];
+    while(node->feature >= 0)
+    {
+        const float value = data[node->feature];
+        if(std::isnan(value) || value == MISSING)
+        {
+            node = &tree.nodes[node->missing];
+        }
+        else if(std::abs(value - node->threshold) <= 1e-5f*std::abs(node->threshold))
+        {
+            return std::max(maxReachableLeaf(tree, node->yes, data), maxReachableLeaf(tree, node->no, data));
+        }
+        else
+        {
+            node = &tree.nodes[value < node->threshold ? node->yes : node->no];
+        }
+    }
+    return node->leaf;
+}
+
+bool TTMXGBoost::rejectEarly(const float* data, double& discUpperBound) const
+{
+    const double threshold = marginThreshold_ - marginTolerance_;
+
+    double margin = marginOffset_;
+    for(unsigned int iTree = 0; iTree <= trees_.size(); ++iTree)
+    {
+        const double marginUpperBound = margin + remainingMax_[iTree];
+        if(marginUpperBound < threshold)
+        {
+            discUpperBound = logistic_ ? 1.0/(1.0 + std::exp(-marginUpperBound)) : marginUpperBound;
+            return true;
+        }
+        if(iTree < trees_.size()) margin += maxReachableLeaf(trees_[iTree], 0, data);
+    }
+
+    return false;
+}
+#endif
@@ -2,6 +2,8 @@
 
 #include "Math/VectorUtil.h"
 
+#include <utility>
+
 TopObject::TopObject() : dRmax_(999.9), discriminator_(-999.9), dThetaMin_(999.9), dThetaMax_(-999.9), scaleFactor_(0.0), type_(TopObject::NONE), inputMVAVars_(nullptr)
 {
 }
@@ -60,6 +62,26 @@ int TopObject::getNBConstituents(double cvsCut, double etaCut) const
     return nb;
 }
 
+uint64_t TopObject::getKey(const std::vector<Constituent>& constituents) const
+{
+    if(constituents_.empty() || constituents_.size() > 3 || constituents.size() >= 0xffff) return 0;
+
+    uint64_t index[3] = {0, 0, 0};
+    for(unsigned int iJet = 0; iJet < constituents_.size(); ++iJet)
+    {
+        const size_t iConst = constituents_[iJet] - constituents.data();
+        if(iConst >= constituents.size()) return 0;
+        index[iJet] = iConst + 1;
+    }
+
+    //sort the three positions so the key does not depend on the constituent order
+    if(index[0] > index[1]) std::swap(index[0], index[1]);
+    if(index[1] > index[2]) std::swap(index[1], index[2]);
+    if(index[0] > index[1]) std::swap(index[0], index[1]);
+
+    return (uint64_t(type_) << 56) | (index[2] << 32) | (index[1] << 16) | index[0];
+}
+
 const TLorentzVector* TopObject::getBestGenTopMatch(const double dRMax) const
 {
     //int genDaughterMatches = 0;
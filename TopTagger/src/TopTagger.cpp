@@ -53,17 +53,15 @@ void TopTagger::setCfgFile(const std::string& cfgFileName)
         }
 
 
-        FILE *f = fopen(cfgFileNameAndPath.c_str(), "r");
-
-        
-
+        //Read in binary mode as the file may be a configuration snapshot
+        FILE *f = fopen(cfgFileNameAndPath.c_str(), "rb");
 
         if(f)
         {
-            char buff[1024];
-            for(; !feof(f) && fgets(buff, 1023, f);)
+            char buff[65536];
+            for(size_t nRead; (nRead = fread(buff, 1, sizeof(buff), f)) > 0;)
             {
-                cfgText += buff;
+                cfgText.append(buff, nRead);
             }
         
             fclose(f);
@@ -74,8 +72,8 @@ void TopTagger::setCfgFile(const std::string& cfgFileName)
             THROW_TTEXCEPTION("Invalid configuration file name \"" + cfgFileNameAndPath + "\"");
         }
 
-        //pass raw text to cfg parser, to return parsed document
-        cfgDoc_ =  cfg::CfgDocument::parseDocument(cfgText);
+        //load snapshots directly, otherwise pass raw text to cfg parser, to return parsed document
+        cfgDoc_ = cfg::CfgDocument::isSnapshot(cfgText) ? cfg::CfgDocument::loadSnapshot(cfgText) : cfg::CfgDocument::parseDocument(cfgText);
 
         //Get TopTagger parameters
         getParameters();
@@ -91,8 +89,8 @@ void TopTagger::setCfgFileDirect(const std::string& cfgText)
     //try-catch the entire function - exceptions rethrown by default
     try
     {
-        //pass raw text to cfg parser, to return parsed document
-        cfgDoc_ =  cfg::CfgDocument::parseDocument(cfgText);
+        //load snapshots directly, otherwise pass raw text to cfg parser, to return parsed document
+        cfgDoc_ = cfg::CfgDocument::isSnapshot(cfgText) ? cfg::CfgDocument::loadSnapshot(cfgText) : cfg::CfgDocument::parseDocument(cfgText);
 
         //Get TopTagger parameters
         getParameters();
@@ -109,44 +107,36 @@ void TopTagger::getParameters()
     cfg::Context cxt("TopTagger");
 
     //Get list of modules to use
-    int iModule = 0;
-    bool keepLooping;
-    do
-    {
-        keepLooping = false;
+    std::vector<std::string> moduleNames;
+    cfgDoc_->getArray("module", cxt, moduleNames);
 
-        //Get module name
-        std::string moduleName = cfgDoc_->get("module", iModule, cxt, "");
+    for(unsigned int iModule = 0; iModule < moduleNames.size(); ++iModule)
+    {
+        const std::string& moduleName = moduleNames[iModule];
         std::string contextName = cfgDoc_->get("context", iModule, cxt, "");
 
-        //if it is a non empty string look for module
-        if(moduleName.size() > 0)
+        //an empty module name ends the list of modules
+        if(moduleName.size() == 0) break;
+
+        //Check in module map for this module
+        if(TTMFactory::moduleExists(moduleName))
         {
-            //Check in module map for this module
-            if(TTMFactory::moduleExists(moduleName))
-            {
-                //if a module is found, try again until one isn't
-                keepLooping = true;
-
-                //if the context name is empty, use the moduleName
-                if(contextName.size() == 0) contextName = moduleName;
-
-                //Create module and add to module to vector
-                topTaggerModules_.emplace_back(TTMFactory::createModule(moduleName));
-                //Set working directory 
-                topTaggerModules_.back()->setWorkingDirectory(workingDirectory_);
-                //configure the new module from the config document
-                topTaggerModules_.back()->getParameters(cfgDoc_.get(), contextName);
-            }
-            else
-            {
-                //throw "TopTagger::getParameters() : No module named \"" + moduleName + "\" exists"; 
-                THROW_TTEXCEPTION("No module named \"" + moduleName + "\" exists");
-            }
+            //if the context name is empty, use the moduleName
+            if(contextName.size() == 0) contextName = moduleName;
+
+            //Create module and add to module to vector
+            topTaggerModules_.emplace_back(TTMFactory::createModule(moduleName));
+            //Set working directory 
+            topTaggerModules_.back()->setWorkingDirectory(workingDirectory_);
+            //configure the new module from the config document
+            topTaggerModules_.back()->getParameters(cfgDoc_.get(), contextName);
+        }
+        else
+        {
+            //throw "TopTagger::getParameters() : No module named \"" + moduleName + "\" exists"; 
+            THROW_TTEXCEPTION("No module named \"" + moduleName + "\" exists");
         }
-        ++iModule;
     }
-    while(keepLooping);
 }
 
 void TopTagger::runTagger(std::vector<Constituent>&& constituents)
@@ -4,11 +4,17 @@
 #include "numpy/arrayobject.h"
 
 #include "TLorentzVector.h"
+#include "TROOT.h"
 #include "Math/VectorUtil.h"
 
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <exception>
 
 #include "TopTagger/TopTagger/interface/TopTagger.h"
 #include "TopTagger/TopTagger/interface/TopTaggerResults.h"
@@ -16,13 +22,47 @@
 #include "TopTagger/TopTagger/interface/TopTaggerUtilities.h"
 #include "TopTagger/CfgParser/include/TTException.h"
 
+/// Top tagger held by the python capsule.  The GIL is released while the tagger runs, so the mutex stops two python threads from using the tagger at the same time.  The extra taggers are made from the same configuration for the threads of runChunk.
+struct TopTaggerSession
+{
+    std::string cfgFile;
+    std::string workingDir;
+    std::unique_ptr<TopTagger> tt;
+    std::vector<std::unique_ptr<TopTagger>> threadTaggers;
+    std::mutex mutex;
+};
+
 /// Destructor function for TopTagger object cleanup 
 static void TopTaggerInterface_cleanup(PyObject *ptt)
 {
-    //Get top tagger pointer from capsule 
-    TopTagger* tt = (TopTagger*) PyCapsule_GetPointer(ptt, "TopTagger");
+    //Get top tagger session pointer from capsule 
+    TopTaggerSession* session = (TopTaggerSession*) PyCapsule_GetPointer(ptt, "TopTagger");
     
-    if(tt) delete tt;
+    if(session) delete session;
+}
+
+/// Create a top tagger from the configuration file, throws TTException on failure
+static std::unique_ptr<TopTagger> TopTaggerInterface_makeTagger(const std::string& cfgFile, const std::string& workingDir)
+{
+    std::unique_ptr<TopTagger> tt(new TopTagger());
+
+    //Disable internal print statements on exception 
+    tt->setVerbosity(0);
+
+    if(workingDir.size() > 0)
+    {
+        tt->setWorkingDirectory(workingDir);
+    }
+    tt->setCfgFile(cfgFile);
+
+    return tt;
+}
+
+/// Lock the session, the GIL is released while waiting as the thread holding the lock may need the GIL to finish (e.g. TTMTFPyBind)
+static void TopTaggerInterface_lockSession(std::unique_lock<std::mutex>& lock)
+{
+    ttPython::GILRelease noGIL;
+    lock.lock();
 }
 
 static ttPython::Py_buffer_wrapper<TLorentzVector> createLorentzP4(PyObject* lorentzVector)
@@ -60,6 +100,54 @@ static ttPython::Py_buffer_wrapper<TLorentzVector> createLorentzP4(PyObject* lor
     return ttPython::Py_buffer_wrapper<TLorentzVector>(nullptr);
 }
 
+/// Filter out jets matched to an isolated lepton or with pt < 20 GeV, the lepton indices are relative to the lepton collections of the event
+template<typename LVCONTAINER, typename INTCONTAINER, typename FLOATCONTAINER, typename BOOLCONTAINER>
+static void TopTaggerInterface_leptonFilter(const LVCONTAINER& jetsLV, const INTCONTAINER& elecIdx1, const INTCONTAINER& muonIdx1, 
+                                            const LVCONTAINER& elecLV, const INTCONTAINER& elecCutBits, const FLOATCONTAINER& elecMiniPFRelIso, 
+                                            const LVCONTAINER& muonLV, const BOOLCONTAINER& muonID, const bool useMuonID, const FLOATCONTAINER& muonPFRelIso, 
+                                            std::vector<unsigned char>& filterVec)
+{
+    for(unsigned int iJet = 0; iJet < jetsLV.size(); ++iJet)
+    {
+        bool isLep = false;
+
+        //recalculate electron ID without isolation 
+        //VID compressed bitmap (MinPtCut,GsfEleSCEtaMultiRangeCut,GsfEleDEtaInSeedCut,GsfEleDPhiInCut,GsfEleFull5x5SigmaIEtaIEtaCut,GsfEleHadronicOverEMEnergyScaledCut,GsfEleEInverseMinusPInverseCut,GsfEleRelPFIsoScaledCut,GsfEleConversionVetoCut,GsfEleMissingHitsCut), 3 bits per cut
+        //this is a 'bit' awful <- that pun is awful, but yes, this should be made a little better 
+        const int iElec = elecIdx1[iJet];
+        if(iElec >= 0 && iElec < static_cast<int>(elecLV.size()) && elecLV[iElec].Pt() > 10.0)
+        {
+            //MAsk relIso from the ID so we can apply miniIso
+            const int NCUTS = 10;
+            const int BITSTRIDE = 3;
+            const int BITMASK = 0x7;
+            const int ISOBITMASK = 070000000;  //note to the curious, 0 before an integer is octal, so 070000000 = 0xE00000 = 14680064, so this corrosponds to the three pfRelIso bits 
+            int cutBits = elecCutBits[iElec] | ISOBITMASK; // the | masks the iso cut
+            int elecID = 07; // start with the largest 3 bit number
+            for(int i = 0; i < NCUTS; ++i)
+            {
+                elecID = std::min(elecID, cutBits & BITMASK);
+                cutBits = cutBits >> BITSTRIDE;
+            }
+
+            double dR = ROOT::Math::VectorUtil::DeltaR(jetsLV[iJet], elecLV[iElec]);
+
+            isLep = isLep || (elecID >= 1 && elecMiniPFRelIso[iElec] < 0.10 && dR < 0.2);
+        }
+            
+        const int iMuon = muonIdx1[iJet];
+        if(iMuon >= 0 && iMuon < static_cast<int>(muonLV.size()) && muonLV[iMuon].Pt() > 10.0)
+        {
+            double dR = ROOT::Math::VectorUtil::DeltaR(jetsLV[iJet], muonLV[iMuon]);
+
+            isLep = isLep || ((!useMuonID || muonID[iMuon]) && muonPFRelIso[iMuon] < 0.2 && dR < 0.2);
+        }
+
+        //filter out jet if it is matched to a lepton, or if it has pt < 20 GeV
+        filterVec[iJet] = !isLep && jetsLV[iJet].Pt() >= 19.9; //better to underclean just a bit because of nanoAOD rounding
+    }
+}
+
 static int TopTaggerInterface_makeAK4Const(
     std::unique_ptr<ttUtility::ConstAK4Inputs<Float_t, ttPython::Py_buffer_wrapper<Float_t>, ttPython::Py_buffer_wrapper<TLorentzVector>>>& ak4ConstInputs, 
     std::vector<ttPython::Py_buffer_wrapper<TLorentzVector>>& tempTLVBuffers, 
@@ -103,47 +191,12 @@ static int TopTaggerInterface_makeAK4Const(
 
     //reserve space for the vector to stop reallocations during emplacing
     filterVec.resize(jetsLV.size(), true);
-    for(unsigned int iJet = 0; iJet < jetsLV.size(); ++iJet)
-    {
-        //check first and last optional parameter ... assume others are here 
-        if(pElectronIdx1 && pMuon_pfRelIso)
-        {
-            bool isLep = false;
 
-            //recalculate electron ID without isolation 
-            //VID compressed bitmap (MinPtCut,GsfEleSCEtaMultiRangeCut,GsfEleDEtaInSeedCut,GsfEleDPhiInCut,GsfEleFull5x5SigmaIEtaIEtaCut,GsfEleHadronicOverEMEnergyScaledCut,GsfEleEInverseMinusPInverseCut,GsfEleRelPFIsoScaledCut,GsfEleConversionVetoCut,GsfEleMissingHitsCut), 3 bits per cut
-            //this is a 'bit' awful <- that pun is awful, but yes, this should be made a little better 
-            if(elecIdx1[iJet] >= 0 && elecLV[elecIdx1[iJet]].Pt() > 10.0)
-            {
-                //MAsk relIso from the ID so we can apply miniIso
-                const int NCUTS = 10;
-                const int BITSTRIDE = 3;
-                const int BITMASK = 0x7;
-                const int ISOBITMASK = 070000000;  //note to the curious, 0 before an integer is octal, so 070000000 = 0xE00000 = 14680064, so this corrosponds to the three pfRelIso bits 
-                int cutBits = elecCutBits[elecIdx1[iJet]] | ISOBITMASK; // the | masks the iso cut
-                int elecID = 07; // start with the largest 3 bit number
-                for(int i = 0; i < NCUTS; ++i)
-                {
-                    elecID = std::min(elecID, cutBits & BITMASK);
-                    cutBits = cutBits >> BITSTRIDE;
-                }
-
-                double dR = ROOT::Math::VectorUtil::DeltaR(jetsLV[iJet], elecLV[elecIdx1[iJet]]);
-
-                isLep = isLep || (elecID >= 1 && elecMiniPFRelIso[elecIdx1[iJet]] < 0.10 && dR < 0.2);
-            }
-            
-            if(muonIdx1[iJet] >= 0 && muonLV[muonIdx1[iJet]].Pt() > 10.0)
-            {
-                double dR = ROOT::Math::VectorUtil::DeltaR(jetsLV[iJet], muonLV[muonIdx1[iJet]]);
-
-                //pMuon_id == Py_None is a hack because moun loose ID is not a variable, but instead only loose muons are saved 
-                isLep = isLep || ((pMuon_id == Py_None || muonID[muonIdx1[iJet]]) && muonPFRelIso[muonIdx1[iJet]] < 0.2 && dR < 0.2);
-            }
-
-            //filter out jet if it is matched to a lepton, or if it has pt < 20 GeV
-            filterVec[iJet] = !isLep && jetsLV[iJet].Pt() >= 19.9; //better to underclean just a bit because of nanoAOD rounding
-        }
+    //check first and last optional parameter ... assume others are here 
+    if(pElectronIdx1 && pMuon_pfRelIso)
+    {
+        //pMuon_id == Py_None is a hack because moun loose ID is not a variable, but instead only loose muons are saved 
+        TopTaggerInterface_leptonFilter(jetsLV, elecIdx1, muonIdx1, elecLV, elecCutBits, elecMiniPFRelIso, muonLV, muonID, pMuon_id != Py_None, muonPFRelIso, filterVec);
     }
 
     //prepare b-tag discriminator
@@ -337,6 +390,410 @@ static inline std::vector<Constituent> createConstituents(A& ak4Inputs, B& ak8In
     }
 }
 
+/// Lorentz vectors of a flat (columnar) collection given as a (pt, eta, phi, mass) tuple of flat arrays
+static int TopTaggerInterface_makeChunkLorentzP4(std::vector<TLorentzVector>& vec, PyObject* pP4Tuple, const npy_intp len)
+{
+    PyObject *pPt, *pEta, *pPhi, *pMass;
+    if(!PyTuple_Check(pP4Tuple) || !PyArg_ParseTuple(pP4Tuple, "OOOO", &pPt, &pEta, &pPhi, &pMass))
+    {
+        if(!PyErr_Occurred()) PyErr_SetString(PyExc_TypeError, "Chunked lorentz vectors must be given as a (pt, eta, phi, mass) tuple");
+        return 1;
+    }
+
+    ttPython::Py_array_wrapper<Float_t> pt, eta, phi, m;
+    if(!pt.set(pPt) || !eta.set(pEta) || !phi.set(pPhi) || !m.set(pMass)) return 1;
+    if(pt.size() < len || eta.size() < len || phi.size() < len || m.size() < len)
+    {
+        PyErr_SetString(PyExc_ValueError, "Chunked lorentz vector content is shorter than its offsets");
+        return 1;
+    }
+
+    vec.resize(len);
+    for(npy_intp i = 0; i < len; ++i)
+    {
+        vec[i].SetPtEtaPhiM(pt.data()[i], eta.data()[i], phi.data()[i], m.data()[i]);
+    }
+
+    return 0;
+}
+
+/// Check the per event offsets of a flat collection, returns the number of elements in the collection or -1 with the python error set
+static npy_intp TopTaggerInterface_checkOffsets(const ttPython::Py_array_wrapper<npy_int64>& offsets, npy_intp& nEvents)
+{
+    if(offsets.size() < 1)
+    {
+        PyErr_SetString(PyExc_ValueError, "Chunked top tagger offsets must have one entry more than the number of events");
+        return -1;
+    }
+
+    if(nEvents < 0) nEvents = offsets.size() - 1;
+    if(offsets.size() - 1 != nEvents)
+    {
+        PyErr_SetString(PyExc_ValueError, "All chunked top tagger inputs must have the same number of events");
+        return -1;
+    }
+
+    const npy_int64* off = offsets.data();
+    if(off[0] != 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "Chunked top tagger offsets must start at 0");
+        return -1;
+    }
+    for(npy_intp iEvt = 0; iEvt < nEvents; ++iEvt)
+    {
+        if(off[iEvt + 1] < off[iEvt])
+        {
+            PyErr_SetString(PyExc_ValueError, "Chunked top tagger offsets must not decrease");
+            return -1;
+        }
+    }
+
+    return off[nEvents];
+}
+
+/// Check that the flat array holds at least len elements
+template<typename T>
+static int TopTaggerInterface_checkChunkContent(const ttPython::Py_array_wrapper<T>& content, const npy_intp len, const bool required = true)
+{
+    if((required || content.valid()) && content.size() < len)
+    {
+        PyErr_SetString(PyExc_ValueError, "Chunked top tagger input content is shorter than its offsets");
+        return 1;
+    }
+    return 0;
+}
+
+/// AK4 jet inputs for a chunk of events stored as flat content with per event offsets
+struct ChunkAK4Inputs
+{
+    ttPython::Py_array_wrapper<npy_int64> offsets;
+    std::vector<TLorentzVector> jetsLV;
+    ttPython::Py_array_wrapper<Float_t> btag;
+    std::vector<std::string> supplamentalNames;
+    std::vector<std::unique_ptr<ttPython::Py_array_wrapper<Float_t>>> supplamentalVars;
+
+    //lepton cleaning inputs
+    bool doLepCleaning;
+    bool useMuonID;
+    ttPython::Py_array_wrapper<Int_t> elecIdx1, muonIdx1;
+    ttPython::Py_array_wrapper<npy_int64> elecOffsets, muonOffsets;
+    std::vector<TLorentzVector> elecLV, muonLV;
+    ttPython::Py_array_wrapper<Int_t> elecCutBits;
+    ttPython::Py_array_wrapper<Float_t> elecMiniPFRelIso, muonPFRelIso;
+    ttPython::Py_array_wrapper<Bool_t> muonID;
+};
+
+/// AK8 jet inputs for a chunk of events stored as flat content with per event offsets, the subjet indices are relative to the subjets of the event
+struct ChunkAK8Inputs
+{
+    ttPython::Py_array_wrapper<npy_int64> offsets, subjetOffsets;
+    std::vector<TLorentzVector> jetsLV, subjetsLV;
+    ttPython::Py_array_wrapper<Float_t> sdMass, topDisc, wDisc;
+    ttPython::Py_array_wrapper<Int_t> subjetIdx1, subjetIdx2;
+};
+
+/// Resolved top candidate inputs for a chunk of events stored as flat content with per event offsets
+struct ChunkResolvedTopInputs
+{
+    ttPython::Py_array_wrapper<npy_int64> offsets;
+    std::vector<TLorentzVector> topCandsLV;
+    ttPython::Py_array_wrapper<Float_t> disc;
+    ttPython::Py_array_wrapper<Int_t> idxJ1, idxJ2, idxJ3;
+};
+
+/// Flat top (or candidate) output for a chunk of events, the rows have the same layout as getResults with per event offsets
+struct ChunkResults
+{
+    static const npy_intp NVARSFLOAT = 5;
+    static const npy_intp NVARSINT = 4;
+
+    std::vector<npy_float> floatVals;
+    std::vector<npy_int> intVals;
+    std::vector<npy_int64> offsets;
+};
+
+static int TopTaggerInterface_makeChunkAK4(ChunkAK4Inputs& inputs, npy_intp& nEvents, PyObject* pArgTuple)
+{
+    PyObject *pOffsets, *pJet, *pJetBtag, *pFloatVarsDict, *pIntVarsDict, *pElectronIdx1 = nullptr, *pMuonIdx1 = nullptr, *pElecOffsets = nullptr, *pElectron = nullptr, *pElectron_cutBasedBits = nullptr, *pElectron_miniPFRelIso = nullptr, *pMuonOffsets = nullptr, *pMuon = nullptr, *pMuon_id = nullptr, *pMuon_pfRelIso = nullptr;
+    if (!PyArg_ParseTuple(pArgTuple, "OOOO!O!|OOOOOOOOOO", &pOffsets, &pJet, &pJetBtag, &PyDict_Type, &pFloatVarsDict, &PyDict_Type, &pIntVarsDict, &pElectronIdx1, &pMuonIdx1, &pElecOffsets, &pElectron, &pElectron_cutBasedBits, &pElectron_miniPFRelIso, &pMuonOffsets, &pMuon, &pMuon_id, &pMuon_pfRelIso))
+    {
+        return 1;
+    }
+
+    if(!inputs.offsets.set(pOffsets)) return 1;
+    const npy_intp nJet = TopTaggerInterface_checkOffsets(inputs.offsets, nEvents);
+    if(nJet < 0) return 1;
+
+    if(TopTaggerInterface_makeChunkLorentzP4(inputs.jetsLV, pJet, nJet)) return 1;
+    if(!inputs.btag.set(pJetBtag) || TopTaggerInterface_checkChunkContent(inputs.btag, nJet)) return 1;
+
+    //prepare supplamental variables, integer variables are converted to float once for the whole chunk
+    PyObject* dicts[] = {pFloatVarsDict, pIntVarsDict};
+    for(PyObject* dict : dicts)
+    {
+        PyObject *key, *value;
+        Py_ssize_t pos = 0;
+        while(PyDict_Next(dict, &pos, &key, &value))
+        {
+            if(!PyString_Check(key))
+            {
+                PyErr_SetString(PyExc_KeyError, "Dictionary keys must be strings for top tagger supplamentary variables.");
+                return 1;
+            }
+
+            inputs.supplamentalNames.emplace_back(PyString_AsString(key));
+            inputs.supplamentalVars.emplace_back(new ttPython::Py_array_wrapper<Float_t>());
+            if(!inputs.supplamentalVars.back()->set(value) || TopTaggerInterface_checkChunkContent(*inputs.supplamentalVars.back(), nJet)) return 1;
+        }
+    }
+
+    //check first and last optional parameter ... assume others are here 
+    inputs.doLepCleaning = pElectronIdx1 && pMuon_pfRelIso;
+    inputs.useMuonID = pMuon_id && pMuon_id != Py_None;
+    if(inputs.doLepCleaning)
+    {
+        if(!inputs.elecIdx1.set(pElectronIdx1) || TopTaggerInterface_checkChunkContent(inputs.elecIdx1, nJet)) return 1;
+        if(!inputs.muonIdx1.set(pMuonIdx1)     || TopTaggerInterface_checkChunkContent(inputs.muonIdx1, nJet)) return 1;
+
+        if(!inputs.elecOffsets.set(pElecOffsets)) return 1;
+        const npy_intp nElec = TopTaggerInterface_checkOffsets(inputs.elecOffsets, nEvents);
+        if(nElec < 0 || TopTaggerInterface_makeChunkLorentzP4(inputs.elecLV, pElectron, nElec)) return 1;
+        if(!inputs.elecCutBits.set(pElectron_cutBasedBits)           || TopTaggerInterface_checkChunkContent(inputs.elecCutBits, nElec)) return 1;
+        if(!inputs.elecMiniPFRelIso.set(pElectron_miniPFRelIso)      || TopTaggerInterface_checkChunkContent(inputs.elecMiniPFRelIso, nElec)) return 1;
+
+        if(!inputs.muonOffsets.set(pMuonOffsets)) return 1;
+        const npy_intp nMuon = TopTaggerInterface_checkOffsets(inputs.muonOffsets, nEvents);
+        if(nMuon < 0 || TopTaggerInterface_makeChunkLorentzP4(inputs.muonLV, pMuon, nMuon)) return 1;
+        if(!inputs.muonID.set(pMuon_id)                              || TopTaggerInterface_checkChunkContent(inputs.muonID, nMuon, inputs.useMuonID)) return 1;
+        if(!inputs.muonPFRelIso.set(pMuon_pfRelIso)                  || TopTaggerInterface_checkChunkContent(inputs.muonPFRelIso, nMuon)) return 1;
+    }
+
+    return 0;
+}
+
+static int TopTaggerInterface_makeChunkAK8(ChunkAK8Inputs& inputs, npy_intp& nEvents, PyObject* pArgTuple)
+{
+    PyObject *pOffsets, *pJet, *pJetSDMass, *pJetTDisc, *pJetWDisc, *pSubjetOffsets, *pSubjet, *pSubjetIdx1, *pSubjetIdx2;
+    if (!PyArg_ParseTuple(pArgTuple, "OOOOOOOOO", &pOffsets, &pJet, &pJetSDMass, &pJetTDisc, &pJetWDisc, &pSubjetOffsets, &pSubjet, &pSubjetIdx1, &pSubjetIdx2))
+    {
+        return 1;
+    }
+
+    if(!inputs.offsets.set(pOffsets)) return 1;
+    const npy_intp nFatJet = TopTaggerInterface_checkOffsets(inputs.offsets, nEvents);
+    if(nFatJet < 0 || TopTaggerInterface_makeChunkLorentzP4(inputs.jetsLV, pJet, nFatJet)) return 1;
+
+    if(!inputs.sdMass.set(pJetSDMass)      || TopTaggerInterface_checkChunkContent(inputs.sdMass, nFatJet)) return 1;
+    if(!inputs.topDisc.set(pJetTDisc)      || TopTaggerInterface_checkChunkContent(inputs.topDisc, nFatJet)) return 1;
+    if(!inputs.wDisc.set(pJetWDisc)        || TopTaggerInterface_checkChunkContent(inputs.wDisc, nFatJet)) return 1;
+    if(!inputs.subjetIdx1.set(pSubjetIdx1) || TopTaggerInterface_checkChunkContent(inputs.subjetIdx1, nFatJet)) return 1;
+    if(!inputs.subjetIdx2.set(pSubjetIdx2) || TopTaggerInterface_checkChunkContent(inputs.subjetIdx2, nFatJet)) return 1;
+
+    if(!inputs.subjetOffsets.set(pSubjetOffsets)) return 1;
+    const npy_intp nSubJet = TopTaggerInterface_checkOffsets(inputs.subjetOffsets, nEvents);
+    if(nSubJet < 0 || TopTaggerInterface_makeChunkLorentzP4(inputs.subjetsLV, pSubjet, nSubJet)) return 1;
+
+    return 0;
+}
+
+static int TopTaggerInterface_makeChunkResolvedTop(ChunkResolvedTopInputs& inputs, npy_intp& nEvents, PyObject* pArgTuple)
+{
+    PyObject *pOffsets, *pTopCand, *pTopCandDisc, *pTopCandIdxJ1, *pTopCandIdxJ2, *pTopCandIdxJ3;
+    if (!PyArg_ParseTuple(pArgTuple, "OOOOOO", &pOffsets, &pTopCand, &pTopCandDisc, &pTopCandIdxJ1, &pTopCandIdxJ2, &pTopCandIdxJ3))
+    {
+        return 1;
+    }
+
+    if(!inputs.offsets.set(pOffsets)) return 1;
+    const npy_intp nResTopCand = TopTaggerInterface_checkOffsets(inputs.offsets, nEvents);
+    if(nResTopCand < 0 || TopTaggerInterface_makeChunkLorentzP4(inputs.topCandsLV, pTopCand, nResTopCand)) return 1;
+
+    if(!inputs.disc.set(pTopCandDisc)   || TopTaggerInterface_checkChunkContent(inputs.disc, nResTopCand)) return 1;
+    if(!inputs.idxJ1.set(pTopCandIdxJ1) || TopTaggerInterface_checkChunkContent(inputs.idxJ1, nResTopCand)) return 1;
+    if(!inputs.idxJ2.set(pTopCandIdxJ2) || TopTaggerInterface_checkChunkContent(inputs.idxJ2, nResTopCand)) return 1;
+    if(!inputs.idxJ3.set(pTopCandIdxJ3) || TopTaggerInterface_checkChunkContent(inputs.idxJ3, nResTopCand)) return 1;
+
+    return 0;
+}
+
+/// Append one top to the flat chunk output
+static void TopTaggerInterface_fillChunkTop(const TopObject& top, ChunkResults& results)
+{
+    results.floatVals.push_back(top.p().Pt());
+    results.floatVals.push_back(top.p().Eta());
+    results.floatVals.push_back(top.p().Phi());
+    results.floatVals.push_back(top.p().M());
+    results.floatVals.push_back(top.getDiscriminator());
+
+    results.intVals.push_back(static_cast<int>(top.getType()));
+
+    //get constituents vector to retrieve matching index
+    const auto& topConstituents = top.getConstituents();
+    for(unsigned int iConst = 0; iConst < 3; ++iConst)
+    {
+        if(topConstituents.size() > iConst) results.intVals.push_back(static_cast<int>(topConstituents[iConst]->getIndex()));
+        else                                results.intVals.push_back(-1);
+    }
+}
+
+/// Run the top tagger over the events [firstEvent, lastEvent) of a chunk, this is pure C++ and does not touch python objects
+static void TopTaggerInterface_runChunkEvents(TopTagger& tt, const ChunkAK4Inputs* ak4Chunk, const ChunkAK8Inputs* ak8Chunk, const ChunkResolvedTopInputs* resTopChunk, 
+                                              const npy_intp firstEvent, const npy_intp lastEvent, const bool saveCandidates, ChunkResults& results)
+{
+    typedef ttPython::Span<Float_t> FloatSpan;
+    typedef ttPython::Span<Int_t> IntSpan;
+    typedef ttPython::Span<TLorentzVector> LVSpan;
+
+    //per event inputs, reused between events
+    std::vector<FloatSpan> supplamentalVars;
+    std::vector<unsigned char> filterVec;
+    std::vector<std::vector<TLorentzVector>> vecSubjetsLV;
+
+    for(npy_intp iEvt = firstEvent; iEvt < lastEvent; ++iEvt)
+    {
+        //the input helpers keep pointers to the spans, so they are declared here to stay in scope until the tagger has run
+        LVSpan ak4JetsLV, ak8JetsLV, topCandsLV;
+        FloatSpan ak4Btag, ak8SDMass, ak8TopDisc, ak8WDisc, topCandDisc;
+        IntSpan topCandIdxJ1, topCandIdxJ2, topCandIdxJ3;
+
+        std::unique_ptr<ttUtility::ConstAK4Inputs<Float_t, FloatSpan, LVSpan>> ak4ConstInputs;
+        if(ak4Chunk)
+        {
+            const npy_int64 first = ak4Chunk->offsets.data()[iEvt];
+            const npy_int64 nJet = ak4Chunk->offsets.data()[iEvt + 1] - first;
+
+            ak4JetsLV = LVSpan(ak4Chunk->jetsLV.data() + first, nJet);
+            ak4Btag = ak4Chunk->btag.span(first, nJet);
+            ak4ConstInputs.reset(new ttUtility::ConstAK4Inputs<Float_t, FloatSpan, LVSpan>(ak4JetsLV, ak4Btag));
+
+            //reserve space for the vector to stop reallocations while the inputs hold pointers to its elements
+            supplamentalVars.clear();
+            supplamentalVars.reserve(ak4Chunk->supplamentalVars.size());
+            for(unsigned int iVar = 0; iVar < ak4Chunk->supplamentalVars.size(); ++iVar)
+            {
+                supplamentalVars.push_back(ak4Chunk->supplamentalVars[iVar]->span(first, nJet));
+                ak4ConstInputs->addSupplamentalVector(ak4Chunk->supplamentalNames[iVar], supplamentalVars.back());
+            }
+
+            filterVec.assign(nJet, true);
+            if(ak4Chunk->doLepCleaning)
+            {
+                const npy_int64 firstElec = ak4Chunk->elecOffsets.data()[iEvt];
+                const npy_int64 nElec = ak4Chunk->elecOffsets.data()[iEvt + 1] - firstElec;
+                const npy_int64 firstMuon = ak4Chunk->muonOffsets.data()[iEvt];
+                const npy_int64 nMuon = ak4Chunk->muonOffsets.data()[iEvt + 1] - firstMuon;
+
+                TopTaggerInterface_leptonFilter(ak4JetsLV, ak4Chunk->elecIdx1.span(first, nJet), ak4Chunk->muonIdx1.span(first, nJet), 
+                                                LVSpan(ak4Chunk->elecLV.data() + firstElec, nElec), ak4Chunk->elecCutBits.span(firstElec, nElec), ak4Chunk->elecMiniPFRelIso.span(firstElec, nElec), 
+                                                LVSpan(ak4Chunk->muonLV.data() + firstMuon, nMuon), ak4Chunk->muonID.span(firstMuon, nMuon), ak4Chunk->useMuonID, ak4Chunk->muonPFRelIso.span(firstMuon, nMuon), 
+                                                filterVec);
+            }
+            ak4ConstInputs->setFilterVector(filterVec);
+        }
+
+        std::unique_ptr<ttUtility::ConstAK8Inputs<Float_t, FloatSpan, LVSpan>> ak8ConstInputs;
+        if(ak8Chunk)
+        {
+            const npy_int64 first = ak8Chunk->offsets.data()[iEvt];
+            const npy_int64 nFatJet = ak8Chunk->offsets.data()[iEvt + 1] - first;
+            const npy_int64 firstSubjet = ak8Chunk->subjetOffsets.data()[iEvt];
+            const npy_int64 nSubJet = ak8Chunk->subjetOffsets.data()[iEvt + 1] - firstSubjet;
+
+            vecSubjetsLV.resize(nFatJet);
+            for(npy_int64 iJet = 0; iJet < nFatJet; ++iJet)
+            {
+                const int idx1 = ak8Chunk->subjetIdx1.data()[first + iJet];
+                const int idx2 = ak8Chunk->subjetIdx2.data()[first + iJet];
+
+                vecSubjetsLV[iJet].clear();
+                if(idx1 >= 0 && idx1 < nSubJet) vecSubjetsLV[iJet].push_back(ak8Chunk->subjetsLV[firstSubjet + idx1]);
+                if(idx2 >= 0 && idx2 < nSubJet) vecSubjetsLV[iJet].push_back(ak8Chunk->subjetsLV[firstSubjet + idx2]);
+            }
+
+            ak8JetsLV = LVSpan(ak8Chunk->jetsLV.data() + first, nFatJet);
+            ak8SDMass = ak8Chunk->sdMass.span(first, nFatJet);
+            ak8TopDisc = ak8Chunk->topDisc.span(first, nFatJet);
+            ak8WDisc = ak8Chunk->wDisc.span(first, nFatJet);
+            ak8ConstInputs.reset(new ttUtility::ConstAK8Inputs<Float_t, FloatSpan, LVSpan>(ak8JetsLV, ak8TopDisc, ak8WDisc, ak8SDMass, vecSubjetsLV));
+        }
+
+        std::unique_ptr<ttUtility::ConstResolvedCandInputs<Float_t, FloatSpan, IntSpan, LVSpan>> resolvedTopConstInputs;
+        if(resTopChunk)
+        {
+            const npy_int64 first = resTopChunk->offsets.data()[iEvt];
+            const npy_int64 nResTopCand = resTopChunk->offsets.data()[iEvt + 1] - first;
+
+            topCandsLV = LVSpan(resTopChunk->topCandsLV.data() + first, nResTopCand);
+            topCandDisc = resTopChunk->disc.span(first, nResTopCand);
+            topCandIdxJ1 = resTopChunk->idxJ1.span(first, nResTopCand);
+            topCandIdxJ2 = resTopChunk->idxJ2.span(first, nResTopCand);
+            topCandIdxJ3 = resTopChunk->idxJ3.span(first, nResTopCand);
+            resolvedTopConstInputs.reset(new ttUtility::ConstResolvedCandInputs<Float_t, FloatSpan, IntSpan, LVSpan>(topCandsLV, topCandDisc, topCandIdxJ1, topCandIdxJ2, topCandIdxJ3));
+        }
+
+        //Run top tagger 
+        tt.runTagger(createConstituents(ak4ConstInputs, ak8ConstInputs, resolvedTopConstInputs));
+
+        const auto& ttr = tt.getResults();
+        if(saveCandidates)
+        {
+            for(const auto& top : ttr.getTopCandidates()) TopTaggerInterface_fillChunkTop(top, results);
+        }
+        else
+        {
+            for(const auto* top : ttr.getTops()) TopTaggerInterface_fillChunkTop(*top, results);
+        }
+        results.offsets.push_back(results.intVals.size()/ChunkResults::NVARSINT);
+    }
+}
+
+/// Run the top tagger over a chunk of events split in contiguous ranges of nPerThread events, one range per tagger with each tagger in its own thread.  The results are concatenated in event order.  Each tagger has its own module instances, so modules which keep state between events see a different sequence of events for different numbers of threads.  This is pure C++ and does not touch python objects.
+static void TopTaggerInterface_runChunkThreads(const std::vector<TopTagger*>& taggers, const ChunkAK4Inputs* ak4Chunk, const ChunkAK8Inputs* ak8Chunk, const ChunkResolvedTopInputs* resTopChunk, 
+                                               const npy_intp nEvents, const npy_intp nPerThread, const bool saveCandidates, ChunkResults& results)
+{
+    if(taggers.size() == 1)
+    {
+        TopTaggerInterface_runChunkEvents(*taggers[0], ak4Chunk, ak8Chunk, resTopChunk, 0, nEvents, saveCandidates, results);
+        return;
+    }
+
+    std::vector<ChunkResults> threadResults(taggers.size());
+    std::vector<std::exception_ptr> errors(taggers.size());
+    auto runRange = [&](const unsigned int iThread)
+    {
+        try
+        {
+            TopTaggerInterface_runChunkEvents(*taggers[iThread], ak4Chunk, ak8Chunk, resTopChunk, iThread*nPerThread, std::min(nEvents, (iThread + 1)*nPerThread), saveCandidates, threadResults[iThread]);
+        }
+        catch(...)
+        {
+            //exceptions can not leave a thread, they are rethrown in the calling thread
+            errors[iThread] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(unsigned int iThread = 1; iThread < taggers.size(); ++iThread)
+    {
+        threads.emplace_back(runRange, iThread);
+    }
+    runRange(0);
+    for(auto& thread : threads) thread.join();
+
+    for(const auto& error : errors)
+    {
+        if(error) std::rethrow_exception(error);
+    }
+
+    //the offsets of each thread count from the first top of its range
+    for(const auto& threadResult : threadResults)
+    {
+        const npy_int64 first = results.offsets.back();
+        for(const npy_int64 offset : threadResult.offsets) results.offsets.push_back(first + offset);
+        results.floatVals.insert(results.floatVals.end(), threadResult.floatVals.begin(), threadResult.floatVals.end());
+        results.intVals.insert(results.intVals.end(), threadResult.intVals.begin(), threadResult.intVals.end());
+    }
+}
 
 extern "C"
 {
@@ -352,27 +809,15 @@ extern "C"
         }
 
         //Setup top tagger 
-        TopTagger *tt = nullptr;
+        std::unique_ptr<TopTaggerSession> session(new TopTaggerSession());
+        session->cfgFile = cfgFile;
+        if(workingDir) session->workingDir = workingDir;
 
         try
         {
-            tt = new TopTagger();
-
-            //Check that "new" succeeded
-            if(!tt)
-            {
-                PyErr_NoMemory();
-                return NULL;
-            }
-
-            //Disable internal print statements on exception 
-            tt->setVerbosity(0);
-
-            if(workingDir && strlen(workingDir) > 0)
-            {
-                tt->setWorkingDirectory(workingDir);
-            }
-            tt->setCfgFile(cfgFile);
+            //loading the configuration and the MVA models is pure C++, let other python threads run meanwhile
+            ttPython::GILRelease noGIL;
+            session->tt = TopTaggerInterface_makeTagger(session->cfgFile, session->workingDir);
         }
         catch(const TTException& e)
         {
@@ -380,8 +825,13 @@ extern "C"
             PyErr_SetString(PyExc_RuntimeError, "TopTagger exception thrown (look above to find specific exception message)");
             return NULL;
         }
+        catch(const std::exception& e)
+        {
+            PyErr_SetString(PyExc_RuntimeError, (std::string("TopTagger C++ exception: ") + e.what()).c_str());
+            return NULL;
+        }
 
-        PyObject * ret = PyCapsule_New(tt, "TopTagger", TopTaggerInterface_cleanup);
+        PyObject * ret = PyCapsule_New(session.release(), "TopTagger", TopTaggerInterface_cleanup);
 
         return Py_BuildValue("N", ret);
     }
@@ -452,9 +902,9 @@ extern "C"
             return NULL;
         }
 
-        //Get top tagger pointer from capsule 
-        TopTagger* tt;
-        if (!(tt = (TopTagger*) PyCapsule_GetPointer(ptt, "TopTagger"))) 
+        //Get top tagger session pointer from capsule 
+        TopTaggerSession* session;
+        if (!(session = (TopTaggerSession*) PyCapsule_GetPointer(ptt, "TopTagger"))) 
         {
             //Handle exception here 
             Py_DECREF(ptt);
@@ -469,11 +919,15 @@ extern "C"
         //Run top tagger
         try
         {
+            //the inputs are held until the end of this function, so the tagger can run without the GIL
+            ttPython::GILRelease noGIL;
+            std::lock_guard<std::mutex> lock(session->mutex);
+
             //create constituent vector 
             const auto constituents = createConstituents(ak4ConstInputs, ak8ConstInputs, resolvedTopConstInputs);
 
             //Run top tagger 
-            tt->runTagger(constituents);
+            session->tt->runTagger(constituents);
         }
         catch(const TTException& e)
         {
@@ -486,6 +940,16 @@ extern "C"
             PyErr_SetString(PyExc_RuntimeError, "TopTagger exception thrown (look above to find specific exception message)");
             return NULL;
         }
+        catch(const std::exception& e)
+        {
+            Py_DECREF(ptt);
+            if(pAK4Inputs) Py_DECREF(pAK4Inputs);
+            if(pAK8Inputs) Py_DECREF(pAK8Inputs);
+            if(pResolvedTopCandInputs) Py_DECREF(pResolvedTopCandInputs);
+
+            PyErr_SetString(PyExc_RuntimeError, (std::string("TopTagger C++ exception: ") + e.what()).c_str());
+            return NULL;
+        }
 
         Py_DECREF(ptt);
         if(pAK4Inputs) Py_DECREF(pAK4Inputs);
@@ -496,6 +960,121 @@ extern "C"
         return Py_None;
     }
 
+    static PyObject* TopTaggerInterface_runChunk(PyObject *self, PyObject *args, PyObject *kwargs)
+    {
+        //suppress unused parameter warning as self is manditory
+        (void)self;
+
+        PyObject *ptt, *pAK4Inputs = nullptr, *pAK8Inputs = nullptr, *pResolvedTopCandInputs = nullptr;
+        int saveCandidates = 0, nThreads = 1;
+        //PYTHON, LEARN ABOUT CONST!!!!!!!!!!!!!!!!!!
+        char kw1[] = "topTagger", kw2[] = "ak4Inputs", kw3[] = "ak8Inputs", kw4[] = "resolvedTopInputs", kw5[] = "saveCandidates", kw6[] = "nThreads";
+        char *keywords[] = {kw1, kw2, kw3, kw4, kw5, kw6, NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|O!O!O!ii", keywords, &PyCapsule_Type, &ptt, &PyTuple_Type, &pAK4Inputs, &PyTuple_Type, &pAK8Inputs, &PyTuple_Type, &pResolvedTopCandInputs, &saveCandidates, &nThreads))
+        {
+            return NULL;
+        }
+
+        if(nThreads < 1)
+        {
+            PyErr_SetString(PyExc_ValueError, "nThreads must be at least 1");
+            return NULL;
+        }
+
+        //Get top tagger session pointer from capsule 
+        TopTaggerSession* session;
+        if (!(session = (TopTaggerSession*) PyCapsule_GetPointer(ptt, "TopTagger"))) 
+        {
+            PyErr_SetString(PyExc_ReferenceError, "TopTagger pointer invalid");
+            return NULL;
+        }
+
+        //Prepare the flat inputs for the whole chunk, the number of events is set by the first offsets array
+        npy_intp nEvents = -1;
+        ChunkAK4Inputs ak4Chunk;
+        if(pAK4Inputs && TopTaggerInterface_makeChunkAK4(ak4Chunk, nEvents, pAK4Inputs)) return NULL;
+
+        ChunkAK8Inputs ak8Chunk;
+        if(pAK8Inputs && TopTaggerInterface_makeChunkAK8(ak8Chunk, nEvents, pAK8Inputs)) return NULL;
+
+        ChunkResolvedTopInputs resTopChunk;
+        if(pResolvedTopCandInputs && TopTaggerInterface_makeChunkResolvedTop(resTopChunk, nEvents, pResolvedTopCandInputs)) return NULL;
+
+        if(nEvents < 0)
+        {
+            PyErr_SetString(PyExc_ValueError, "No top tagger inputs given");
+            return NULL;
+        }
+
+        ChunkResults results;
+        results.offsets.reserve(nEvents + 1);
+        results.offsets.push_back(0);
+
+        //the chunk inputs hold references to python objects and are destroyed at the end of this function with the GIL held
+        std::unique_lock<std::mutex> lock(session->mutex, std::defer_lock);
+        TopTaggerInterface_lockSession(lock);
+
+        //Run top tagger 
+        try
+        {
+            ttPython::GILRelease noGIL;
+
+            //use no more threads than needed to give each thread at least one event
+            const npy_intp nPerThread = std::max<npy_intp>(1, (nEvents + nThreads - 1)/nThreads);
+            const npy_intp nUsedThreads = std::max<npy_intp>(1, (nEvents + nPerThread - 1)/nPerThread);
+
+            //the extra taggers are made from the configuration file the first time they are needed and kept for later chunks
+            while(static_cast<npy_intp>(session->threadTaggers.size()) + 1 < nUsedThreads)
+            {
+                session->threadTaggers.push_back(TopTaggerInterface_makeTagger(session->cfgFile, session->workingDir));
+            }
+
+            std::vector<TopTagger*> taggers = {session->tt.get()};
+            for(npy_intp iThread = 1; iThread < nUsedThreads; ++iThread) taggers.push_back(session->threadTaggers[iThread - 1].get());
+
+            TopTaggerInterface_runChunkThreads(taggers, pAK4Inputs ? &ak4Chunk : nullptr, pAK8Inputs ? &ak8Chunk : nullptr, pResolvedTopCandInputs ? &resTopChunk : nullptr, nEvents, nPerThread, saveCandidates, results);
+        }
+        catch(const TTException& e)
+        {
+            std::cout << "TopTagger exception message: " << e << std::endl;
+            PyErr_SetString(PyExc_RuntimeError, "TopTagger exception thrown (look above to find specific exception message)");
+            return NULL;
+        }
+        catch(const std::exception& e)
+        {
+            //std::system_error if a thread can not be started or an exception rethrown from a tagger thread, C++ exceptions must not cross the C API
+            PyErr_SetString(PyExc_RuntimeError, (std::string("TopTagger C++ exception: ") + e.what()).c_str());
+            return NULL;
+        }
+        lock.unlock();
+
+        //create numpy arrays for passing top data to python
+        const npy_intp NTOPS = static_cast<npy_intp>(results.offsets.back());
+
+        npy_intp floatsizearray[] = {NTOPS, ChunkResults::NVARSFLOAT};
+        PyArrayObject* topArrayFloat = reinterpret_cast<PyArrayObject*>(PyArray_SimpleNew(2, floatsizearray, NPY_FLOAT));
+
+        npy_intp intsizearray[] = {NTOPS, ChunkResults::NVARSINT};
+        PyArrayObject* topArrayInt = reinterpret_cast<PyArrayObject*>(PyArray_SimpleNew(2, intsizearray, NPY_INT));
+
+        npy_intp offsetsizearray[] = {static_cast<npy_intp>(results.offsets.size())};
+        PyArrayObject* offsetArray = reinterpret_cast<PyArrayObject*>(PyArray_SimpleNew(1, offsetsizearray, NPY_INT64));
+
+        if(!topArrayFloat || !topArrayInt || !offsetArray)
+        {
+            Py_XDECREF(topArrayFloat);
+            Py_XDECREF(topArrayInt);
+            Py_XDECREF(offsetArray);
+            return NULL;
+        }
+
+        std::copy(results.floatVals.begin(), results.floatVals.end(), static_cast<npy_float*>(PyArray_DATA(topArrayFloat)));
+        std::copy(results.intVals.begin(), results.intVals.end(), static_cast<npy_int*>(PyArray_DATA(topArrayInt)));
+        std::copy(results.offsets.begin(), results.offsets.end(), static_cast<npy_int64*>(PyArray_DATA(offsetArray)));
+
+        return Py_BuildValue("NNN", topArrayFloat, topArrayInt, offsetArray);
+    }
+
     static PyObject* TopTaggerInterface_getResults(PyObject *self, PyObject *args)
     {
         //suppress unused parameter warning as self is manditory
@@ -509,9 +1088,9 @@ extern "C"
 
         Py_INCREF(ptt);
 
-        //Get top tagger pointer from capsule 
-        TopTagger* tt;
-        if (!(tt = (TopTagger*) PyCapsule_GetPointer(ptt, "TopTagger"))) 
+        //Get top tagger session pointer from capsule 
+        TopTaggerSession* session;
+        if (!(session = (TopTaggerSession*) PyCapsule_GetPointer(ptt, "TopTagger"))) 
         {
             //Handle exception here 
             Py_DECREF(ptt);
@@ -522,8 +1101,12 @@ extern "C"
 
         try
         {
+            //hold the lock while reading the results so they are not changed by a tagger running in another thread
+            std::unique_lock<std::mutex> lock(session->mutex, std::defer_lock);
+            TopTaggerInterface_lockSession(lock);
+
             //Get top tagger results 
-            const auto& ttr = tt->getResults();
+            const auto& ttr = session->tt->getResults();
 
             //Get tops 
             const auto& tops = ttr.getTops();
@@ -574,6 +1157,13 @@ extern "C"
             PyErr_SetString(PyExc_RuntimeError, "TopTagger exception thrown (look above to find specific exception message)");
             return NULL;
         }
+        catch(const std::exception& e)
+        {
+            Py_DECREF(ptt);
+
+            PyErr_SetString(PyExc_RuntimeError, (std::string("TopTagger C++ exception: ") + e.what()).c_str());
+            return NULL;
+        }
 
     }
 
@@ -590,9 +1180,9 @@ extern "C"
 
         Py_INCREF(ptt);
 
-        //Get top tagger pointer from capsule 
-        TopTagger* tt;
-        if (!(tt = (TopTagger*) PyCapsule_GetPointer(ptt, "TopTagger"))) 
+        //Get top tagger session pointer from capsule 
+        TopTaggerSession* session;
+        if (!(session = (TopTaggerSession*) PyCapsule_GetPointer(ptt, "TopTagger"))) 
         {
             //Handle exception here 
             Py_DECREF(ptt);
@@ -603,8 +1193,12 @@ extern "C"
 
         try
         {
+            //hold the lock while reading the results so they are not changed by a tagger running in another thread
+            std::unique_lock<std::mutex> lock(session->mutex, std::defer_lock);
+            TopTaggerInterface_lockSession(lock);
+
             //Get top tagger results 
-            const auto& ttr = tt->getResults();
+            const auto& ttr = session->tt->getResults();
 
             //Get tops 
             const auto& tops = ttr.getTopCandidates();
@@ -655,6 +1249,13 @@ extern "C"
             PyErr_SetString(PyExc_RuntimeError, "TopTagger exception thrown (look above to find specific exception message)");
             return NULL;
         }
+        catch(const std::exception& e)
+        {
+            Py_DECREF(ptt);
+
+            PyErr_SetString(PyExc_RuntimeError, (std::string("TopTagger C++ exception: ") + e.what()).c_str());
+            return NULL;
+        }
 
     }
 
@@ -685,6 +1286,7 @@ extern "C"
         {"test",       TopTaggerInterface_test,            METH_VARARGS,                 "test."},
         {"setup",         TopTaggerInterface_setup,            METH_VARARGS,                 "Configure Top Tagger."},
         {"run",           (PyCFunction)TopTaggerInterface_run, METH_VARARGS | METH_KEYWORDS, "Run Top Tagger."},
+        {"runChunk",      (PyCFunction)TopTaggerInterface_runChunk, METH_VARARGS | METH_KEYWORDS, "Run Top Tagger over a chunk of events with flat (columnar) inputs."},
         {"getResults",    TopTaggerInterface_getResults,       METH_VARARGS,                 "Get Top Tagger results."},
         {"getCandidates", TopTaggerInterface_getCandidates,    METH_VARARGS,                 "Get Top Tagger Candidates."},
         {NULL, NULL, 0, NULL}        /* Sentinel */
@@ -695,6 +1297,14 @@ extern "C"
     {
         (void) Py_InitModule("TopTaggerInterface", TopTaggerInterfaceMethods);
 
+        //the GIL is released while the tagger runs and TTMTFPyBind may take it from the threads of runChunk
+#if PY_VERSION_HEX < 0x03070000
+        PyEval_InitThreads();
+#endif
+
+        //taggers run in parallel both in the threads of runChunk and in separate python threads, so ROOT (e.g. the TMVA readers of TTMTMVA) must be made thread safe before any tagger is created
+        ROOT::EnableThreadSafety();
+
         //Setup numpy
         import_array();
     }
@@ -8,6 +8,15 @@
 #include <utility>
 #include <regex>
 #include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace ttUtility
 {
@@ -21,7 +30,7 @@ namespace ttUtility
     }
 
 
-    double coreMT2calc(const TLorentzVector & fatJet1LVec, const TLorentzVector & fatJet2LVec, const TLorentzVector& metLVec)
+    double coreMT2calc(const TLorentzVector & fatJet1LVec, const TLorentzVector & fatJet2LVec, const TLorentzVector& metLVec, const MT2Precision& precision, double* errorBound, const double stopAboveMT2 = 0)
     {
         // The input parameters associated with the particle
         // (or collection of particles) associated with the
@@ -46,7 +55,7 @@ namespace ttUtility
         // "half" of the event:    
         const double invis_mass    = metLVec.M(); // GeV
 
-        double desiredPrecisionOnMt2 = 0; // Must be >=0.  If 0 alg aims for machine precision.  if >0, MT2 computed to supplied absolute precision.
+        double desiredPrecisionOnMt2 = precision.absTolerance; // Must be >=0.  If 0 alg aims for machine precision.  if >0, MT2 computed to supplied absolute precision.
 
         //asymm_mt2_lester_bisect::disableCopyrightMessage();
 
@@ -55,19 +64,63 @@ namespace ttUtility
             massOfSystemB, pxOfSystemB, pyOfSystemB,
             pxMiss, pyMiss,
             invis_mass, invis_mass,
-            desiredPrecisionOnMt2);
+            desiredPrecisionOnMt2,
+            true,
+            stopAboveMT2,
+            precision.relTolerance,
+            precision.maxIterations,
+            errorBound);
 
         return mt2;
 
     }
 
-    double calculateMT2(const TopTaggerResults& ttr, const TLorentzVector& metLVec)
+    //MT2 of a pair is at least the larger of the two visible masses plus the invisible mass
+    inline double mt2LowerBound(const TLorentzVector& fatJet1LVec, const TLorentzVector& fatJet2LVec, const TLorentzVector& metLVec)
+    {
+        return std::max(fatJet1LVec.M(), fatJet2LVec.M()) + metLVec.M();
+    }
+
+    //Minimum MT2 over all pairs of tops, the pairs are evaluated in order of their lower bound so that pairs which can not give a smaller MT2 are skipped or stopped early
+    //The error bound is the largest bound of the pairs not stopped early, the pairs stopped early are above the returned minimum without any error
+    double minPairMT2(const std::vector<TopObject*>& tops, const TLorentzVector& metLVec, const MT2Precision& precision, double& errorBound, std::vector<std::tuple<double, unsigned int, unsigned int>>& pairs)
+    {
+        pairs.clear();
+        for(unsigned int it=0; it<tops.size(); it++)
+        {
+            for(unsigned int jt=it+1; jt<tops.size(); jt++)
+            {
+                pairs.emplace_back(mt2LowerBound(tops[it]->P(), tops[jt]->P(), metLVec), it, jt);
+            } 
+        }
+        std::sort(pairs.begin(), pairs.end());
+
+        double minMT2 = std::numeric_limits<double>::infinity();
+        errorBound = 0.0;
+        for(const auto& pair : pairs)
+        {
+            //this and all following pairs can not be below the current minimum
+            if(std::get<0>(pair) >= minMT2) break;
+
+            double pairErrorBound;
+            const double mt2 = coreMT2calc(tops[std::get<1>(pair)]->P(), tops[std::get<2>(pair)]->P(), metLVec, precision, &pairErrorBound, std::max(minMT2, 0.0));
+            minMT2 = std::min(minMT2, mt2);
+            if(!std::isinf(pairErrorBound)) errorBound = std::max(errorBound, pairErrorBound);
+        }
+
+        return minMT2;
+    }
+
+    //MT2 of one event, the pair list is scratch space which can be reused between events
+    double eventMT2(const TopTaggerResults& ttr, const TLorentzVector& metLVec, const MT2Precision& precision, double& errorBound, std::vector<std::tuple<double, unsigned int, unsigned int>>& pairs)
     {
         TLorentzVector fatJet1LVec(0, 0, 0,0);
         TLorentzVector fatJet2LVec(0, 0, 0,0);
         //Use result for top var
         const std::vector<TopObject*> &Ntop = ttr.getTops();  
 
+        errorBound = 0.0;
+
         if (Ntop.size() == 0)
         {
             return 0.0;
@@ -78,32 +131,135 @@ namespace ttUtility
             fatJet1LVec = Ntop.at(0)->P();
             fatJet2LVec = ttr.getRsys().P();
      
-            return coreMT2calc(fatJet1LVec, fatJet2LVec, metLVec);
+            return coreMT2calc(fatJet1LVec, fatJet2LVec, metLVec, precision, &errorBound);
         }
 
         if (Ntop.size() >= 2)
         {
-            std::vector<double> cachedMT2vec;
-            for(unsigned int it=0; it<Ntop.size(); it++)
-            {
-                for(unsigned int jt=it+1; jt<Ntop.size(); jt++)
-                {
-                    cachedMT2vec.push_back(coreMT2calc(Ntop.at(it)->P(), Ntop.at(jt)->P(), metLVec));
-                } 
-            }
-            std::sort(cachedMT2vec.begin(), cachedMT2vec.end());
-
-            return cachedMT2vec.front();
+            return minPairMT2(Ntop, metLVec, precision, errorBound, pairs);
         }
 
         return 0.0;
     }
 
+    void checkMT2Precision(const MT2Precision& precision)
+    {
+        if(precision.absTolerance < 0.0 || precision.relTolerance < 0.0)
+        {
+            THROW_TTEXCEPTION("MT2 tolerances must be non-negative");
+        }
+    }
+
+    double calculateMT2(const TopTaggerResults& ttr, const TLorentzVector& metLVec, const MT2Precision& precision, double* errorBound)
+    {
+        checkMT2Precision(precision);
+
+        std::vector<std::tuple<double, unsigned int, unsigned int>> pairs;
+        double eventErrorBound;
+        const double mt2 = eventMT2(ttr, metLVec, precision, eventErrorBound, pairs);
+        if(errorBound) *errorBound = eventErrorBound;
+
+        return mt2;
+    }
+
+    void calculateMT2(const std::vector<const TopTaggerResults*>& ttrs, const std::vector<TLorentzVector>& metLVecs, std::vector<double>& mt2, const MT2Precision& precision)
+    {
+        if(ttrs.size() != metLVecs.size())
+        {
+            THROW_TTEXCEPTION("Number of tagger results and MET vectors do not match");
+        }
+        checkMT2Precision(precision);
+
+        //the pair list is reused between events
+        std::vector<std::tuple<double, unsigned int, unsigned int>> pairs;
+        double errorBound;
+        mt2.resize(ttrs.size());
+        for(unsigned int iEvt = 0; iEvt < ttrs.size(); ++iEvt)
+        {
+            mt2[iEvt] = eventMT2(*ttrs[iEvt], metLVecs[iEvt], precision, errorBound, pairs);
+        }
+    }
+
     inline double relu(const double x, const double bias = 0.0)
     {
         return (x > bias)?x:0.0;
     }
 
+    MVAInputCalculator::MVAInputCalculator() : basePtr_(nullptr), len_(0), eventConstituents_(nullptr), nEventConstituents_(0), eventResults_(nullptr) {}
+
+    void MVAInputCalculator::setConstituents(const std::vector<Constituent>& constituents)
+    {
+        eventConstituents_ = constituents.data();
+        nEventConstituents_ = constituents.size();
+        eventResults_ = nullptr;
+    }
+
+    void MVAInputCalculator::setEventResults(const TopTaggerResults& ttResults)
+    {
+        setConstituents(ttResults.getConstituents());
+        eventResults_ = &ttResults;
+    }
+
+    int MVAInputCalculator::constituentIndex(const Constituent* constituent) const
+    {
+        if(eventConstituents_ != nullptr && constituent >= eventConstituents_ && constituent < eventConstituents_ + nEventConstituents_)
+        {
+            return constituent - eventConstituents_;
+        }
+        return -1;
+    }
+
+    void MVAInputCalculator::calculateEventVars(TopTaggerResults& ttResults, const std::vector<std::string>& vars, std::vector<TopObject*>& cands)
+    {
+        setEventResults(ttResults);
+
+        //Find the store column of each variable, creating missing columns
+        const TopObject* firstCand = ttResults.getTopCandidates().data();
+        const unsigned int nCand = ttResults.getTopCandidates().size();
+        const TopObject::Type candType = getCandType();
+        std::vector<TopTaggerResults::MVAInputColumn*> columns;
+        columns.reserve(vars.size());
+        for(const auto& var : vars)
+        {
+            auto& column = ttResults.getMVAInputs()[TopTaggerResults::MVAInputKey(candType, var)];
+            if(column.values.size() < nCand)
+            {
+                column.values.resize(nCand);
+                column.filled.resize(nCand, false);
+            }
+            columns.push_back(&column);
+        }
+
+        unsigned int iRow = 0;
+        for(auto* topCand : cands)
+        {
+            const int iCand = topCand - firstCand;
+            float* row = basePtr_ + len_*iRow;
+
+            //Copy the row if every variable was already calculated for this candidate
+            bool inStore = true;
+            for(unsigned int iVar = 0; iVar < columns.size() && inStore; ++iVar)
+            {
+                inStore = columns[iVar]->filled[iCand];
+                row[iVar] = columns[iVar]->values[iCand];
+            }
+
+            if(!inStore)
+            {
+                if(!calculateVars(*topCand, iRow)) continue;
+                for(unsigned int iVar = 0; iVar < columns.size(); ++iVar)
+                {
+                    columns[iVar]->values[iCand] = row[iVar];
+                    columns[iVar]->filled[iCand] = true;
+                }
+            }
+
+            cands[iRow] = topCand;
+            ++iRow;
+        }
+        cands.resize(iRow);
+    }
+
     BDTMonojetInputCalculator::BDTMonojetInputCalculator()
     {
         ak8_sdmass_ = ak8_tau21_ = ak8_tau32_ = ak8_ptDR_ = ak8_rel_ptdiff_ = ak8_csv1_mass_ = ak8_csv1_csv_ = ak8_csv1_ptD_ = ak8_csv1_axis1_ = ak8_csv1_mult_ = ak8_csv2_mass_ = ak8_csv2_ptD_ = ak8_csv2_axis1_ = ak8_csv2_mult_ = -1;
@@ -170,6 +326,11 @@ namespace ttUtility
             && topCand.getConstituents()[0]->getSubjets().size() == 2;
     }
 
+    TopObject::Type BDTMonojetInputCalculator::getCandType() const
+    {
+        return TopObject::MERGED_TOP;
+    }
+
     BDTDijetInputCalculator::BDTDijetInputCalculator()
     {
         var_fj_sdmass_ = var_fj_tau21_ = var_fj_ptDR_ = var_fj_rel_ptdiff_ = var_sj1_ptD_ = var_sj1_axis1_ = var_sj1_mult_ = var_sj2_ptD_ = var_sj2_axis1_ = var_sj2_mult_ = var_sjmax_csv_ = var_sd_n2_ = -1;
@@ -178,6 +339,7 @@ namespace ttUtility
     void BDTDijetInputCalculator::mapVars(const std::vector<std::string>& vars)
     {
         len_ = vars.size();
+        mappedVars_.clear();
         
         for(unsigned int i = 0; i < vars.size(); ++i)
         {
@@ -193,7 +355,45 @@ namespace ttUtility
             else if(vars[i].compare("var_sj2_mult") == 0)       var_sj2_mult_ = i;
             else if(vars[i].compare("var_sjmax_csv") == 0)      var_sjmax_csv_ = i;
             else if(vars[i].compare("var_sd_n2") == 0)          var_sd_n2_ = i;
+            else continue;
+
+            mappedVars_.push_back(i);
+        }
+    }
+
+    void BDTDijetInputCalculator::setConstituents(const std::vector<Constituent>& constituents)
+    {
+        MVAInputCalculator::setConstituents(constituents);
+
+        fatjetCache_.resize(constituents.size() * len_);
+        fatjetCacheState_.assign(constituents.size(), NOT_FILLED);
+    }
+
+    bool BDTDijetInputCalculator::calculateFatjetVars(const Constituent& fatjet, float* row) const
+    {
+        if(var_fj_sdmass_ >= 0)     row[var_fj_sdmass_]   = fatjet.getSoftDropMass();
+        if(var_fj_tau21_ >= 0)      row[var_fj_tau21_]    = fatjet.getTau1() > 0 ? fatjet.getTau2()/fatjet.getTau1() : 1e9;
+        // filling subjet variables
+        if(fatjet.getSubjets().size() < 2) return false;
+        const auto *sj1 = &fatjet.getSubjets()[0];
+        const auto *sj2 = &fatjet.getSubjets()[1];
+        double fj_deltaR =  ROOT::Math::VectorUtil::DeltaR(sj1->p(), sj2->p());
+        if(var_fj_ptDR_ >= 0)       row[var_fj_ptDR_]       = fj_deltaR*fatjet.p().Pt();
+        if(var_fj_rel_ptdiff_ >= 0) row[var_fj_rel_ptdiff_] = std::abs(sj1->p().Pt()-sj2->p().Pt())/fatjet.p().Pt();
+        if(var_sj1_ptD_ >= 0)       row[var_sj1_ptD_]       = sj1->getExtraVar("ptD");
+        if(var_sj1_axis1_ >= 0)     row[var_sj1_axis1_]     = sj1->getExtraVar("axis1");
+        if(var_sj1_mult_ >= 0)      row[var_sj1_mult_]      = sj1->getExtraVar("mult");
+        if(var_sj2_ptD_ >= 0)       row[var_sj2_ptD_]       = sj2->getExtraVar("ptD");
+        if(var_sj2_axis1_ >= 0)     row[var_sj2_axis1_]     = sj2->getExtraVar("axis1");
+        if(var_sj2_mult_ >= 0)      row[var_sj2_mult_]      = sj2->getExtraVar("mult");
+        if(var_sjmax_csv_ >= 0)     row[var_sjmax_csv_]     = std::max(std::max(sj1->getBTagDisc(),sj2->getBTagDisc()),0.0);
+        if(var_sd_n2_ >= 0)
+        {
+            double var_sd_0 = sj2->p().Pt()/(sj1->p().Pt()+sj2->p().Pt());
+            row[var_sd_n2_]         = var_sd_0/std::pow(fj_deltaR,-2);
         }
+
+        return true;
     }
         
     bool BDTDijetInputCalculator::calculateVars(const TopObject& topCand, int iCand)
@@ -202,27 +402,22 @@ namespace ttUtility
         {
             const auto* fatjet = topCand.getConstituents()[0];
             if(fatjet->getType() != Constituent::AK8JET) fatjet = topCand.getConstituents()[1];
-            if(var_fj_sdmass_ >= 0)     *(basePtr_ + var_fj_sdmass_ + len_*iCand)   = fatjet->getSoftDropMass();
-            if(var_fj_tau21_ >= 0)      *(basePtr_ + var_fj_tau21_ + len_*iCand)    = fatjet->getTau1() > 0 ? fatjet->getTau2()/fatjet->getTau1() : 1e9;
-            // filling subjet variables
-            if(fatjet->getSubjets().size() < 2) return false;
-            const auto *sj1 = &fatjet->getSubjets()[0];
-            const auto *sj2 = &fatjet->getSubjets()[1];
-            double fj_deltaR =  ROOT::Math::VectorUtil::DeltaR(sj1->p(), sj2->p());
-            if(var_fj_ptDR_ >= 0)       *(basePtr_ + var_fj_ptDR_ + len_*iCand)       = fj_deltaR*fatjet->p().Pt();
-            if(var_fj_rel_ptdiff_ >= 0) *(basePtr_ + var_fj_rel_ptdiff_ + len_*iCand) = std::abs(sj1->p().Pt()-sj2->p().Pt())/fatjet->p().Pt();
-            if(var_sj1_ptD_ >= 0)       *(basePtr_ + var_sj1_ptD_ + len_*iCand)       = sj1->getExtraVar("ptD");
-            if(var_sj1_axis1_ >= 0)     *(basePtr_ + var_sj1_axis1_ + len_*iCand)     = sj1->getExtraVar("axis1");
-            if(var_sj1_mult_ >= 0)      *(basePtr_ + var_sj1_mult_ + len_*iCand)      = sj1->getExtraVar("mult");
-            if(var_sj2_ptD_ >= 0)       *(basePtr_ + var_sj2_ptD_ + len_*iCand)       = sj2->getExtraVar("ptD");
-            if(var_sj2_axis1_ >= 0)     *(basePtr_ + var_sj2_axis1_ + len_*iCand)     = sj2->getExtraVar("axis1");
-            if(var_sj2_mult_ >= 0)      *(basePtr_ + var_sj2_mult_ + len_*iCand)      = sj2->getExtraVar("mult");
-            if(var_sjmax_csv_ >= 0)     *(basePtr_ + var_sjmax_csv_ + len_*iCand)     = std::max(std::max(sj1->getBTagDisc(),sj2->getBTagDisc()),0.0);
-            if(var_sd_n2_ >= 0)
+
+            float* row = basePtr_ + len_*iCand;
+
+            //Without an event table calculate the variables directly
+            int iFatjet = constituentIndex(fatjet);
+            if(iFatjet < 0) return calculateFatjetVars(*fatjet, row);
+
+            //Otherwise the AK8 jet variables are only calculated for its first candidate
+            float* cached = fatjetCache_.data() + len_*iFatjet;
+            if(fatjetCacheState_[iFatjet] == NOT_FILLED)
             {
-                double var_sd_0 = sj2->p().Pt()/(sj1->p().Pt()+sj2->p().Pt());
-                *(basePtr_ + var_sd_n2_ + len_*iCand)       = var_sd_0/std::pow(fj_deltaR,-2);
+                fatjetCacheState_[iFatjet] = calculateFatjetVars(*fatjet, cached) ? FILLED : INVALID;
             }
+            if(fatjetCacheState_[iFatjet] == INVALID) return false;
+
+            for(const int iVar : mappedVars_) row[iVar] = cached[iVar];
 
             return true;
         }
@@ -236,6 +431,11 @@ namespace ttUtility
             && topCand.getType() == TopObject::SEMIMERGEDWB_TOP;
     }
 
+    TopObject::Type BDTDijetInputCalculator::getCandType() const
+    {
+        return TopObject::SEMIMERGEDWB_TOP;
+    }
+
     TrijetInputCalculator::TrijetInputCalculator()
     {
         cand_pt_ = -1;
@@ -249,6 +449,7 @@ namespace ttUtility
         dRPtTop_ = -1;
         dRPtW_ = -1;
         sd_n2_ = -1;
+        needRestFrame_ = false;
 
         for(unsigned int i = 0; i < NCONST; ++i)
         {
@@ -403,158 +604,296 @@ namespace ttUtility
                 if(vars[j].compare("j"   + std::to_string(iMin + 1) + std::to_string(iMax + 1) + "_m") == 0)      j12_m_[i] = j;
             }
         }
+
+        compilePlan();
+    }
+
+    void TrijetInputCalculator::addOp(const FeatureType type, const int offset, const int jet)
+    {
+        if(offset < 0) return;
+
+        //index of next jets (assumes < 4 jets)
+        plan_.push_back({type, offset, jet, (jet + 1) % NCONST, (jet + 2) % NCONST, -1});
+        if(type >= RF_P) needRestFrame_ = true;
+    }
+
+    void TrijetInputCalculator::addJetOp(const FeatureType type, const int offset, const int jet, const JetVarType jetVarType, const std::string& var, const double bias)
+    {
+        if(offset < 0) return;
+
+        //reuse the jet table entry if the same quantity is already requested for another variable
+        int iJetVar = 0;
+        for(; iJetVar < static_cast<int>(jetVars_.size()); ++iJetVar)
+        {
+            const auto& jetVar = jetVars_[iJetVar];
+            if(jetVar.type == jetVarType && jetVar.var == var && jetVar.bias == bias) break;
+        }
+        if(iJetVar == static_cast<int>(jetVars_.size())) jetVars_.push_back({jetVarType, var, bias});
+
+        addOp(type, offset, jet);
+        plan_.back().jetVar = iJetVar;
+    }
+
+    void TrijetInputCalculator::compilePlan()
+    {
+        plan_.clear();
+        jetVars_.clear();
+        needRestFrame_ = false;
+
+        //Get top candidate variables
+        addOp(CAND_PT,        cand_pt_);
+        addOp(CAND_P,         cand_p_);
+        addOp(CAND_ETA,       cand_eta_);
+        addOp(CAND_PHI,       cand_phi_);
+        addOp(CAND_M,         cand_m_);
+        addOp(CAND_DRMAX,     cand_dRMax_);
+        addOp(CAND_DTHETAMIN, cand_dThetaMin_);
+        addOp(CAND_DTHETAMAX, cand_dThetaMax_);
+        addOp(DRPT_TOP,       dRPtTop_);
+        addOp(DRPT_W,         dRPtW_);
+        addOp(SD_N2,          sd_n2_);
+
+        //Get constituent variables before deboost
+        for(int i = 0; i < NCONST; ++i)
+        {
+            addJetOp(LAB_JETVAR, j_m_lab_[i],       i, JET_M);
+            addJetOp(LAB_JETVAR, j_CSV_lab_[i],     i, JET_CSV);
+            addJetOp(LAB_JETVAR, j_QGL_lab_[i],     i, JET_EXTRAVAR, "qgLikelihood");
+            addJetOp(LAB_JETVAR, j_qgPtD_lab_[i],   i, JET_EXTRAVAR, "qgPtD");
+            addJetOp(LAB_JETVAR, j_qgAxis1_lab_[i], i, JET_EXTRAVAR, "qgAxis1");
+            addJetOp(LAB_JETVAR, j_qgAxis2_lab_[i], i, JET_EXTRAVAR, "qgAxis2");
+            addJetOp(LAB_JETVAR, j_qgMult_lab_[i],  i, JET_EXTRAVAR, "qgMult");
+            addJetOp(LAB_JETVAR, j_CvsL_lab_[i],    i, JET_EXTRAVAR, "CvsL");
+            addOp(LAB_DR,        dR12_lab_[i],      i);
+            addOp(LAB_DR_3,      dR12_3_lab_[i],    i);
+            addOp(LAB_PAIR_M,    j12_m_lab_[i],     i);
+        }
+
+        //Get constituent variables in the top rest frame
+        for(int i = 0; i < NCONST; ++i)
+        {
+            addOp(RF_P,         j_p_[i],         i);
+            addJetOp(RF_JETVAR, j_p_top_[i],     i, JET_P);
+            addOp(RF_THETA_TOP, j_theta_top_[i], i);
+            addOp(RF_PHI_TOP,   j_phi_top_[i],   i);
+            addJetOp(RF_JETVAR, j_phi_lab_[i],   i, JET_PHI);
+            addJetOp(RF_JETVAR, j_eta_lab_[i],   i, JET_ETA);
+            addJetOp(RF_JETVAR, j_pt_lab_[i],    i, JET_PT);
+            addOp(RF_M,         j_m_[i],         i);
+            addJetOp(RF_JETVAR, j_CSV_[i],       i, JET_CSV);
+            //Here we fake the QGL if it is a b jet
+            addJetOp(RF_JETVAR, j_QGL_[i],       i, JET_QGL);
+
+            addJetOp(RF_JETVAR, j_recoJetsJecScaleRawToFull_[i],           i, JET_EXTRAVAR, "recoJetsJecScaleRawToFull");
+            addJetOp(RF_JETVAR, j_qgLikelihood_[i],                        i, JET_EXTRAVAR, "qgLikelihood");
+            addJetOp(RF_JETVAR, j_qgPtD_[i],                               i, JET_EXTRAVAR, "qgPtD");
+            addJetOp(RF_JETVAR, j_qgAxis1_[i],                             i, JET_EXTRAVAR, "qgAxis1");
+            addJetOp(RF_JETVAR, j_qgAxis2_[i],                             i, JET_EXTRAVAR, "qgAxis2");
+            addJetOp(RF_JETVAR, j_recoJetschargedHadronEnergyFraction_[i], i, JET_EXTRAVAR, "recoJetschargedHadronEnergyFraction");
+            addJetOp(RF_JETVAR, j_recoJetschargedEmEnergyFraction_[i],     i, JET_EXTRAVAR, "recoJetschargedEmEnergyFraction");
+            addJetOp(RF_JETVAR, j_recoJetsneutralEmEnergyFraction_[i],     i, JET_EXTRAVAR, "recoJetsneutralEmEnergyFraction");
+            addJetOp(RF_JETVAR, j_recoJetsmuonEnergyFraction_[i],          i, JET_EXTRAVAR, "recoJetsmuonEnergyFraction");
+            addJetOp(RF_JETVAR, j_recoJetsHFHadronEnergyFraction_[i],      i, JET_EXTRAVAR, "recoJetsHFHadronEnergyFraction");
+            addJetOp(RF_JETVAR, j_recoJetsHFEMEnergyFraction_[i],          i, JET_EXTRAVAR, "recoJetsHFEMEnergyFraction");
+            addJetOp(RF_JETVAR, j_recoJetsneutralEnergyFraction_[i],       i, JET_EXTRAVAR, "recoJetsneutralEnergyFraction");
+            addJetOp(RF_JETVAR, j_PhotonEnergyFraction_[i],                i, JET_EXTRAVAR, "PhotonEnergyFraction");
+            addJetOp(RF_JETVAR, j_ElectronEnergyFraction_[i],              i, JET_EXTRAVAR, "ElectronEnergyFraction");
+            addJetOp(RF_JETVAR, j_ChargedHadronMultiplicity_[i],           i, JET_EXTRAVAR, "ChargedHadronMultiplicity");
+            addJetOp(RF_JETVAR, j_NeutralHadronMultiplicity_[i],           i, JET_EXTRAVAR, "NeutralHadronMultiplicity");
+            addJetOp(RF_JETVAR, j_PhotonMultiplicity_[i],                  i, JET_EXTRAVAR, "PhotonMultiplicity");
+            addJetOp(RF_JETVAR, j_ElectronMultiplicity_[i],                i, JET_EXTRAVAR, "ElectronMultiplicity");
+            addJetOp(RF_JETVAR, j_MuonMultiplicity_[i],                    i, JET_EXTRAVAR, "MuonMultiplicity");
+            addJetOp(RF_JETVAR, j_DeepCSVb_[i],                            i, JET_EXTRAVAR, "DeepCSVb");
+            addJetOp(RF_JETVAR, j_DeepCSVc_[i],                            i, JET_EXTRAVAR, "DeepCSVc");
+            addJetOp(RF_JETVAR, j_DeepCSVl_[i],                            i, JET_EXTRAVAR, "DeepCSVl");
+            addJetOp(RF_JETVAR, j_DeepCSVbb_[i],                           i, JET_EXTRAVAR, "DeepCSVbb");
+            addOp(RF_ZERO,      j_DeepCSVcc_[i],                           i);
+            addJetOp(RF_JETVAR, j_DeepFlavorb_[i],                         i, JET_EXTRAVAR, "DeepFlavorb");
+            addJetOp(RF_JETVAR, j_DeepFlavorbb_[i],                        i, JET_EXTRAVAR, "DeepFlavorbb");
+            addJetOp(RF_JETVAR, j_DeepFlavorlepb_[i],                      i, JET_EXTRAVAR, "DeepFlavorlepb");
+            addJetOp(RF_JETVAR, j_DeepFlavorc_[i],                         i, JET_EXTRAVAR, "DeepFlavorc");
+            addJetOp(RF_JETVAR, j_DeepFlavoruds_[i],                       i, JET_EXTRAVAR, "DeepFlavoruds");
+            addJetOp(RF_JETVAR, j_DeepFlavorg_[i],                         i, JET_EXTRAVAR, "DeepFlavorg");
+            addJetOp(RF_JETVAR, j_CvsL_[i],                                i, JET_EXTRAVAR, "CvsL");
+            addJetOp(RF_JETVAR, j_CvsB_[i],                                i, JET_EXTRAVAR, "CvsB");
+            addJetOp(RF_JETVAR, j_CombinedSvtx_[i],                        i, JET_EXTRAVAR, "CombinedSvtx");
+            addJetOp(RF_JETVAR, j_JetProba_[i],                            i, JET_EXTRAVAR, "JetProba");
+            addJetOp(RF_JETVAR, j_JetBprob_[i],                            i, JET_EXTRAVAR, "JetBprob");
+            addJetOp(RF_JETVAR, j_recoJetsBtag_[i],                        i, JET_EXTRAVAR, "recoJetsBtag");
+            addJetOp(RF_JETVAR, j_recoJetsCharge_[i],                      i, JET_EXTRAVAR, "recoJetsCharge", -2);
+            addJetOp(RF_JETVAR, j_qgMult_[i],                              i, JET_EXTRAVAR, "qgMult");
+
+            addOp(RF_DTHETA,    dTheta_[i], i);
+            addOp(RF_PAIR_M,    j12_m_[i],  i);
+        }
+
+        jetScratch_.resize(NCONST * jetVars_.size());
+    }
+
+    void TrijetInputCalculator::setConstituents(const std::vector<Constituent>& constituents)
+    {
+        MVAInputCalculator::setConstituents(constituents);
+
+        jetTable_.resize(constituents.size() * jetVars_.size());
+        jetTableFilled_.assign(constituents.size(), false);
+    }
+
+    void TrijetInputCalculator::calculateJetVars(const Constituent& jet, double* values) const
+    {
+        for(unsigned int i = 0; i < jetVars_.size(); ++i)
+        {
+            const auto& jetVar = jetVars_[i];
+            switch(jetVar.type)
+            {
+            case JET_M:        values[i] = jet.p().M();                                break;
+            case JET_P:        values[i] = jet.p().P();                                break;
+            case JET_PT:       values[i] = jet.p().Pt();                               break;
+            case JET_ETA:      values[i] = jet.p().Eta();                              break;
+            case JET_PHI:      values[i] = jet.p().Phi();                              break;
+            case JET_CSV:      values[i] = jet.getBTagDisc();                          break;
+            case JET_QGL:      values[i] = jet.getQGLikelihood();                      break;
+            case JET_EXTRAVAR: values[i] = relu(jet.getExtraVar(jetVar.var), jetVar.bias); break;
+            }
+        }
+    }
+
+    const double* TrijetInputCalculator::getJetVars(const Constituent& jet, const int iJet)
+    {
+        //jets which are not in the event table (or if setConstituents was not called) are calculated into the scratch space
+        int iConst = constituentIndex(&jet);
+        if(iConst < 0)
+        {
+            double* values = jetScratch_.data() + iJet*jetVars_.size();
+            calculateJetVars(jet, values);
+            return values;
+        }
+
+        double* values = jetTable_.data() + iConst*jetVars_.size();
+        if(!jetTableFilled_[iConst])
+        {
+            calculateJetVars(jet, values);
+            jetTableFilled_[iConst] = true;
+        }
+        return values;
+    }
+
+    const TopTaggerResults::ConstituentPair& TrijetInputCalculator::getPair(const Constituent& jet1, const Constituent& jet2, const int iPair)
+    {
+        //pairs of jets which are not in the event constituents (or if setEventResults was not called) are calculated into the scratch space
+        int iConst1 = constituentIndex(&jet1);
+        int iConst2 = constituentIndex(&jet2);
+        if(eventResults_ != nullptr && iConst1 >= 0 && iConst2 >= 0)
+        {
+            return eventResults_->getConstituentPair(iConst1, iConst2);
+        }
+
+        auto& pair = pairScratch_[iPair];
+        pair.p = jet1.p() + jet2.p();
+        pair.dR = ROOT::Math::VectorUtil::DeltaR(jet1.p(), jet2.p());
+        pair.m = pair.p.M();
+        return pair;
     }
         
     bool TrijetInputCalculator::calculateVars(const TopObject& topCand, int iCand)
     {
         if(checkCand(topCand))
         {
-            //std::map<std::string, double> varMap;
-
-            //Get top candidate variables
-            if(cand_pt_ >= 0)        *(basePtr_ + cand_pt_ + len_*iCand)        = topCand.p().Pt();
-            if(cand_p_ >= 0)         *(basePtr_ + cand_p_ + len_*iCand)         = topCand.p().P();
-            if(cand_eta_ >= 0)       *(basePtr_ + cand_eta_ + len_*iCand)       = topCand.p().Eta();
-            if(cand_phi_ >= 0)       *(basePtr_ + cand_phi_ + len_*iCand)       = topCand.p().Phi();
-            if(cand_m_ >= 0)         *(basePtr_ + cand_m_ + len_*iCand)         = topCand.p().M();
-            if(cand_dRMax_ >= 0)     *(basePtr_ + cand_dRMax_ + len_*iCand)     = topCand.getDRmax();
-            if(cand_dThetaMin_ >= 0) *(basePtr_ + cand_dThetaMin_ + len_*iCand) = topCand.getDThetaMin();
-            if(cand_dThetaMax_ >= 0) *(basePtr_ + cand_dThetaMax_ + len_*iCand) = topCand.getDThetaMax();
+            float* row = basePtr_ + len_*iCand;
 
-            //Get Constituents
-            //Get a copy instead of the reference
-            std::vector<Constituent const *> top_constituents = topCand.getConstituents();
+            //Get constituents
+            const Constituent* jets[NCONST];
+            std::copy(topCand.getConstituents().begin(), topCand.getConstituents().end(), jets);
 
             //resort by CSV
-            std::sort(top_constituents.begin(), top_constituents.end(), [](const Constituent * const c1, const Constituent * const c2){ return c1->getBTagDisc() > c2->getBTagDisc(); });
+            std::sort(jets, jets + NCONST, [](const Constituent * const c1, const Constituent * const c2){ return c1->getBTagDisc() > c2->getBTagDisc(); });
             //switch candidates 2 and 3 if they are not in Pt ordering 
-            if(top_constituents[2]->p().Pt() > top_constituents[1]->p().Pt())
+            if(jets[2]->p().Pt() > jets[1]->p().Pt())
             {
-                std::swap(top_constituents[1], top_constituents[2]);
+                std::swap(jets[1], jets[2]);
             }
 
-            //Get constituent variables before deboost
-            for(unsigned int i = 0; i < top_constituents.size(); ++i)
-            {
-                if(j_m_lab_[i] >= 0)       *(basePtr_ + j_m_lab_[i] + len_*iCand)       = top_constituents[i]->p().M();
-                if(j_CSV_lab_[i] >= 0)     *(basePtr_ + j_CSV_lab_[i] + len_*iCand)     = top_constituents[i]->getBTagDisc();
-                if(j_QGL_[i] >= 0)          *(basePtr_ + j_QGL_lab_[i] + len_*iCand)      = relu(top_constituents[i]->getExtraVar("qgLikelihood"));
-                if(j_qgPtD_lab_[i] >= 0)    *(basePtr_ + j_qgPtD_lab_[i] + len_*iCand)    = relu(top_constituents[i]->getExtraVar("qgPtD"));
-                if(j_qgAxis1_lab_[i] >= 0)  *(basePtr_ + j_qgAxis1_lab_[i] + len_*iCand)  = relu(top_constituents[i]->getExtraVar("qgAxis1"));
-                if(j_qgAxis2_lab_[i] >= 0)  *(basePtr_ + j_qgAxis2_lab_[i] + len_*iCand)  = relu(top_constituents[i]->getExtraVar("qgAxis2"));
-                if(j_qgMult_lab_[i] >= 0)   *(basePtr_ + j_qgMult_lab_[i] + len_*iCand)   = relu(top_constituents[i]->getExtraVar("qgMult"));            
-                if(j_CvsL_lab_[i] >= 0)     *(basePtr_ + j_CvsL_lab_[i] + len_*iCand)     = relu(top_constituents[i]->getExtraVar("CvsL"));
-
-                //index of next jet (assumes < 4 jets)
-                unsigned int iNext = (i + 1) % top_constituents.size();
-                unsigned int iNNext = (i + 2) % top_constituents.size();
-                //unsigned int iMin = std::min(i, iNext);
-                //unsigned int iMax = std::max(i, iNext);
-
-                //Calculate the angle variables
-                if(dR12_lab_[i] >= 0)   *(basePtr_ + dR12_lab_[i] + len_*iCand)   = ROOT::Math::VectorUtil::DeltaR(top_constituents[i]->p(), top_constituents[iNext]->p());
-                if(dR12_3_lab_[i] >= 0) *(basePtr_ + dR12_3_lab_[i] + len_*iCand) = ROOT::Math::VectorUtil::DeltaR(top_constituents[iNNext]->p(), top_constituents[i]->p() + top_constituents[iNext]->p());
-
-                //calculate pair masses
-                auto jetPair = top_constituents[i]->p() + top_constituents[iNext]->p();
-                if(j12_m_lab_[i] >= 0) *(basePtr_ + j12_m_lab_[i] + len_*iCand) = jetPair.M();
-            }
+            //single jet quantities from the per event jet table
+            const double* jetVars[NCONST];
+            for(int i = 0; i < NCONST; ++i) jetVars[i] = getJetVars(*jets[i], i);
 
-            if(dRPtTop_ >= 0) *(basePtr_ + dRPtTop_ + len_*iCand) = ROOT::Math::VectorUtil::DeltaR(top_constituents[0]->p(), top_constituents[1]->p() + top_constituents[2]->p()) * topCand.p().Pt();
-            if(dRPtW_ >= 0) *(basePtr_ + dRPtW_ + len_*iCand) = ROOT::Math::VectorUtil::DeltaR(top_constituents[1]->p(), top_constituents[2]->p()) * (top_constituents[1]->p() + top_constituents[2]->p()).Pt();
-            if(sd_n2_ >= 0) 
+            //deboost the constituents into the top rest frame and re-sort them by p
+            TLorentzVector rfP4[NCONST];
+            const Constituent* rfJets[NCONST];
+            const double* rfJetVars[NCONST];
+            if(needRestFrame_)
             {
-                double var_sd_0 = top_constituents[2]->p().Pt()/(top_constituents[1]->p().Pt()+top_constituents[2]->p().Pt());
-                double var_WdR = ROOT::Math::VectorUtil::DeltaR(top_constituents[1]->p(), top_constituents[2]->p());
-                *(basePtr_ + sd_n2_ + len_*iCand) = var_sd_0 / pow(var_WdR, -2);
+                const TVector3 boost = -topCand.p().BoostVector();
+                TLorentzVector p4[NCONST];
+                int order[NCONST];
+                for(int i = 0; i < NCONST; ++i)
+                {
+                    p4[i] = jets[i]->p();
+                    p4[i].Boost(boost);
+                    order[i] = i;
+                }
+                std::sort(order, order + NCONST, [&p4](const int i1, const int i2){ return p4[i1].P() > p4[i2].P(); });
+                for(int i = 0; i < NCONST; ++i)
+                {
+                    rfP4[i] = p4[order[i]];
+                    rfJets[i] = jets[order[i]];
+                    rfJetVars[i] = jetVars[order[i]];
+                }
             }
 
-            std::vector<Constituent> RF_constituents;
-
-            for(const auto& constitutent : top_constituents)
+            for(const auto& op : plan_)
             {
-                TLorentzVector p4(constitutent->p());
-                p4.Boost(-topCand.p().BoostVector());
-                RF_constituents.emplace_back(*constitutent);
-                RF_constituents.back().setP(p4);
-            }
-
-            //re-sort constituents by p after deboosting
-            std::sort(RF_constituents.begin(), RF_constituents.end(), [](const Constituent& c1, const Constituent& c2){ return c1.p().P() > c2.p().P(); });
+                float& value = row[op.offset];
+                switch(op.type)
+                {
+                case CAND_PT:        value = topCand.p().Pt();        break;
+                case CAND_P:         value = topCand.p().P();         break;
+                case CAND_ETA:       value = topCand.p().Eta();       break;
+                case CAND_PHI:       value = topCand.p().Phi();       break;
+                case CAND_M:         value = topCand.p().M();         break;
+                case CAND_DRMAX:     value = topCand.getDRmax();      break;
+                case CAND_DTHETAMIN: value = topCand.getDThetaMin();  break;
+                case CAND_DTHETAMAX: value = topCand.getDThetaMax();  break;
+                case DRPT_TOP:
+                    value = ROOT::Math::VectorUtil::DeltaR(jets[0]->p(), jets[1]->p() + jets[2]->p()) * topCand.p().Pt();
+                    break;
+                case DRPT_W:
+                {
+                    const auto& pair = getPair(*jets[1], *jets[2], 2);
+                    value = pair.dR * pair.p.Pt();
+                    break;
+                }
+                case SD_N2:
+                {
+                    double var_sd_0 = jets[2]->p().Pt()/(jets[1]->p().Pt()+jets[2]->p().Pt());
+                    double var_WdR = getPair(*jets[1], *jets[2], 2).dR;
+                    value = var_sd_0 / pow(var_WdR, -2);
+                    break;
+                }
 
-            //Get constituent variables
-            for(unsigned int i = 0; i < RF_constituents.size(); ++i)
-            {
-                if(j_p_[i] >= 0) *(basePtr_ + j_p_[i] + len_*iCand)     = RF_constituents[i].p().P();
-
-                //This is a bit silly
-                TLorentzVector p4(RF_constituents[i].p());
-                p4.Boost(topCand.p().BoostVector());
-                if(j_p_top_[i] >= 0)     *(basePtr_ + j_p_top_[i] + len_*iCand)     = p4.P();
-                if(j_theta_top_[i] >= 0) *(basePtr_ + j_theta_top_[i] + len_*iCand) = topCand.p().Angle(p4.Vect());
-                if(j_phi_top_[i] >= 0)   *(basePtr_ + j_phi_top_[i] + len_*iCand)   = ROOT::Math::VectorUtil::DeltaPhi(RF_constituents[i].p(), RF_constituents[0].p());
-
-                if(j_phi_lab_[i] >= 0) *(basePtr_ + j_phi_lab_[i] + len_*iCand)   = p4.Phi();
-                if(j_eta_lab_[i] >= 0) *(basePtr_ + j_eta_lab_[i] + len_*iCand)   = p4.Eta();
-                if(j_pt_lab_[i] >= 0)  *(basePtr_ + j_pt_lab_[i] + len_*iCand)    = p4.Pt();
-            
-                if(j_m_[i] >= 0)   *(basePtr_ + j_m_[i] + len_*iCand)     = RF_constituents[i].p().M();
-                if(j_CSV_[i] >= 0) *(basePtr_ + j_CSV_[i] + len_*iCand)   = RF_constituents[i].getBTagDisc();
-                //Here we fake the QGL if it is a b jet
-                if(j_QGL_[i] >= 0) *(basePtr_ + j_QGL_[i] + len_*iCand)   = RF_constituents[i].getQGLikelihood();
-
-                if(j_recoJetsJecScaleRawToFull_[i] >= 0)           *(basePtr_ + j_recoJetsJecScaleRawToFull_[i] + len_*iCand)           = relu(RF_constituents[i].getExtraVar("recoJetsJecScaleRawToFull"));
-                if(j_qgLikelihood_[i] >= 0)                        *(basePtr_ + j_qgLikelihood_[i] + len_*iCand)                        = relu(RF_constituents[i].getExtraVar("qgLikelihood"));
-                if(j_qgPtD_[i] >= 0)                               *(basePtr_ + j_qgPtD_[i] + len_*iCand)                               = relu(RF_constituents[i].getExtraVar("qgPtD"));
-                if(j_qgAxis1_[i] >= 0)                             *(basePtr_ + j_qgAxis1_[i] + len_*iCand)                             = relu(RF_constituents[i].getExtraVar("qgAxis1"));
-                if(j_qgAxis2_[i] >= 0)                             *(basePtr_ + j_qgAxis2_[i] + len_*iCand)                             = relu(RF_constituents[i].getExtraVar("qgAxis2"));
-                if(j_recoJetschargedHadronEnergyFraction_[i] >= 0) *(basePtr_ + j_recoJetschargedHadronEnergyFraction_[i] + len_*iCand) = relu(RF_constituents[i].getExtraVar("recoJetschargedHadronEnergyFraction"));
-                if(j_recoJetschargedEmEnergyFraction_[i] >= 0)     *(basePtr_ + j_recoJetschargedEmEnergyFraction_[i] + len_*iCand)     = relu(RF_constituents[i].getExtraVar("recoJetschargedEmEnergyFraction"));
-                if(j_recoJetsneutralEmEnergyFraction_[i] >= 0)     *(basePtr_ + j_recoJetsneutralEmEnergyFraction_[i] + len_*iCand)     = relu(RF_constituents[i].getExtraVar("recoJetsneutralEmEnergyFraction"));
-                if(j_recoJetsmuonEnergyFraction_[i] >= 0)          *(basePtr_ + j_recoJetsmuonEnergyFraction_[i] + len_*iCand)          = relu(RF_constituents[i].getExtraVar("recoJetsmuonEnergyFraction"));
-                if(j_recoJetsHFHadronEnergyFraction_[i] >= 0)      *(basePtr_ + j_recoJetsHFHadronEnergyFraction_[i] + len_*iCand)      = relu(RF_constituents[i].getExtraVar("recoJetsHFHadronEnergyFraction"));
-                if(j_recoJetsHFEMEnergyFraction_[i] >= 0)          *(basePtr_ + j_recoJetsHFEMEnergyFraction_[i] + len_*iCand)          = relu(RF_constituents[i].getExtraVar("recoJetsHFEMEnergyFraction"));
-                if(j_recoJetsneutralEnergyFraction_[i] >= 0)       *(basePtr_ + j_recoJetsneutralEnergyFraction_[i] + len_*iCand)       = relu(RF_constituents[i].getExtraVar("recoJetsneutralEnergyFraction"));
-                if(j_PhotonEnergyFraction_[i] >= 0)                *(basePtr_ + j_PhotonEnergyFraction_[i] + len_*iCand)                = relu(RF_constituents[i].getExtraVar("PhotonEnergyFraction"));
-                if(j_ElectronEnergyFraction_[i] >= 0)              *(basePtr_ + j_ElectronEnergyFraction_[i] + len_*iCand)              = relu(RF_constituents[i].getExtraVar("ElectronEnergyFraction"));
-                if(j_ChargedHadronMultiplicity_[i] >= 0)           *(basePtr_ + j_ChargedHadronMultiplicity_[i] + len_*iCand)           = relu(RF_constituents[i].getExtraVar("ChargedHadronMultiplicity"));
-                if(j_NeutralHadronMultiplicity_[i] >= 0)           *(basePtr_ + j_NeutralHadronMultiplicity_[i] + len_*iCand)           = relu(RF_constituents[i].getExtraVar("NeutralHadronMultiplicity"));
-                if(j_PhotonMultiplicity_[i] >= 0)                  *(basePtr_ + j_PhotonMultiplicity_[i] + len_*iCand)                  = relu(RF_constituents[i].getExtraVar("PhotonMultiplicity"));
-                if(j_ElectronMultiplicity_[i] >= 0)                *(basePtr_ + j_ElectronMultiplicity_[i] + len_*iCand)                = relu(RF_constituents[i].getExtraVar("ElectronMultiplicity"));
-                if(j_MuonMultiplicity_[i] >= 0)                    *(basePtr_ + j_MuonMultiplicity_[i] + len_*iCand)                    = relu(RF_constituents[i].getExtraVar("MuonMultiplicity"));
-                if(j_DeepCSVb_[i] >= 0)                            *(basePtr_ + j_DeepCSVb_[i] + len_*iCand)                            = relu(RF_constituents[i].getExtraVar("DeepCSVb"));
-                if(j_DeepCSVc_[i] >= 0)                            *(basePtr_ + j_DeepCSVc_[i] + len_*iCand)                            = relu(RF_constituents[i].getExtraVar("DeepCSVc"));
-                if(j_DeepCSVl_[i] >= 0)                            *(basePtr_ + j_DeepCSVl_[i] + len_*iCand)                            = relu(RF_constituents[i].getExtraVar("DeepCSVl"));
-                if(j_DeepCSVbb_[i] >= 0)                           *(basePtr_ + j_DeepCSVbb_[i] + len_*iCand)                           = relu(RF_constituents[i].getExtraVar("DeepCSVbb"));
-                if(j_DeepCSVcc_[i] >= 0)                           *(basePtr_ + j_DeepCSVcc_[i] + len_*iCand)                           = 0.0;
-                if(j_DeepFlavorb_[i] >= 0)                         *(basePtr_ + j_DeepFlavorb_[i] + len_*iCand)                         = relu(RF_constituents[i].getExtraVar("DeepFlavorb"));
-                if(j_DeepFlavorbb_[i] >= 0)                        *(basePtr_ + j_DeepFlavorbb_[i] + len_*iCand)                        = relu(RF_constituents[i].getExtraVar("DeepFlavorbb"));
-                if(j_DeepFlavorlepb_[i] >= 0)                      *(basePtr_ + j_DeepFlavorlepb_[i] + len_*iCand)                      = relu(RF_constituents[i].getExtraVar("DeepFlavorlepb"));
-                if(j_DeepFlavorc_[i] >= 0)                         *(basePtr_ + j_DeepFlavorc_[i] + len_*iCand)                         = relu(RF_constituents[i].getExtraVar("DeepFlavorc"));
-                if(j_DeepFlavoruds_[i] >= 0)                       *(basePtr_ + j_DeepFlavoruds_[i] + len_*iCand)                       = relu(RF_constituents[i].getExtraVar("DeepFlavoruds"));
-                if(j_DeepFlavorg_[i] >= 0)                         *(basePtr_ + j_DeepFlavorg_[i] + len_*iCand)                         = relu(RF_constituents[i].getExtraVar("DeepFlavorg"));
-                if(j_CvsL_[i] >= 0)                                *(basePtr_ + j_CvsL_[i] + len_*iCand)                                = relu(RF_constituents[i].getExtraVar("CvsL"));
-                if(j_CvsB_[i] >= 0)                                *(basePtr_ + j_CvsB_[i] + len_*iCand)                                = relu(RF_constituents[i].getExtraVar("CvsB"));
-                if(j_CombinedSvtx_[i] >= 0)                        *(basePtr_ + j_CombinedSvtx_[i] + len_*iCand)                        = relu(RF_constituents[i].getExtraVar("CombinedSvtx"));
-                if(j_JetProba_[i] >= 0)                            *(basePtr_ + j_JetProba_[i] + len_*iCand)                            = relu(RF_constituents[i].getExtraVar("JetProba"));
-                if(j_JetBprob_[i] >= 0)                            *(basePtr_ + j_JetBprob_[i] + len_*iCand)                            = relu(RF_constituents[i].getExtraVar("JetBprob"));
-                if(j_recoJetsBtag_[i] >= 0)                        *(basePtr_ + j_recoJetsBtag_[i] + len_*iCand)                        = relu(RF_constituents[i].getExtraVar("recoJetsBtag"));
-                if(j_recoJetsCharge_[i] >= 0)                      *(basePtr_ + j_recoJetsCharge_[i] + len_*iCand)                      = relu(RF_constituents[i].getExtraVar("recoJetsCharge"), -2);
-                if(j_qgMult_[i] >= 0)                              *(basePtr_ + j_qgMult_[i] + len_*iCand)                              = relu(RF_constituents[i].getExtraVar("qgMult"));            
-
-                //index of next jet (assumes < 4 jets)
-                unsigned int iNext = (i + 1) % RF_constituents.size();
-                unsigned int iMin = std::min(i, iNext);
-                unsigned int iMax = std::max(i, iNext);
-
-                //Calculate delta angle variables
-                if(dTheta_[i] >= 0) *(basePtr_ + dTheta_[i] + len_*iCand) = RF_constituents[iMin].p().Angle(RF_constituents[iMax].p().Vect());
-
-                //calculate pair masses
-                auto jetPair = RF_constituents[i].p() + RF_constituents[iNext].p();
-                if(j12_m_[i] >= 0) *(basePtr_ + j12_m_[i] + len_*iCand) = jetPair.M();
+                //Lab frame constituent variables
+                case LAB_JETVAR:   value = jetVars[op.jet][op.jetVar];                           break;
+                case LAB_DR:       value = getPair(*jets[op.jet], *jets[op.jetNext], op.jet + op.jetNext - 1).dR; break;
+                case LAB_DR_3:     value = ROOT::Math::VectorUtil::DeltaR(jets[op.jetNNext]->p(), getPair(*jets[op.jet], *jets[op.jetNext], op.jet + op.jetNext - 1).p); break;
+                case LAB_PAIR_M:   value = getPair(*jets[op.jet], *jets[op.jetNext], op.jet + op.jetNext - 1).m; break;
+
+                //Rest frame constituent variables, the lab frame quantities use the same p ordering as the rest frame
+                case RF_P:         value = rfP4[op.jet].P();                                           break;
+                case RF_JETVAR:    value = rfJetVars[op.jet][op.jetVar];                               break;
+                case RF_THETA_TOP: value = topCand.p().Angle(rfJets[op.jet]->p().Vect());              break;
+                case RF_PHI_TOP:   value = ROOT::Math::VectorUtil::DeltaPhi(rfP4[op.jet], rfP4[0]);    break;
+                case RF_M:         value = rfP4[op.jet].M();                                           break;
+                case RF_ZERO:      value = 0.0;                                                        break;
+                case RF_DTHETA:
+                {
+                    int iMin = std::min(op.jet, op.jetNext);
+                    int iMax = std::max(op.jet, op.jetNext);
+                    value = rfP4[iMin].Angle(rfP4[iMax].Vect());
+                    break;
+                }
+                case RF_PAIR_M:    value = (rfP4[op.jet] + rfP4[op.jetNext]).M();                     break;
+                }
             }
-                
+
             return true;
         }
             
@@ -567,6 +906,11 @@ namespace ttUtility
             && topCand.getType() == TopObject::RESOLVED_TOP;
     }
 
+    TopObject::Type TrijetInputCalculator::getCandType() const
+    {
+        return TopObject::RESOLVED_TOP;
+    }
+
     std::vector<std::string> getMVAVars()
     {
         return std::vector<std::string>({"genTopPt",
@@ -893,4 +1237,70 @@ namespace ttUtility
         }
     }
 
+    MappedFile::MappedFile(const std::string& file) : data_(nullptr), size_(0), mapped_(false)
+    {
+        std::string fname=file;
+        autoExpandEnvironmentVariables(fname);
+
+        int fd = open(fname.c_str(), O_RDONLY);
+        if(fd < 0)
+        {
+            THROW_TTEXCEPTION("File not found: \"" + file + "\"");
+        }
+
+        struct stat fileStat;
+        if(fstat(fd, &fileStat) != 0)
+        {
+            close(fd);
+            THROW_TTEXCEPTION("ERROR: Unable to read file: \"" + file + "\"");
+        }
+        size_ = fileStat.st_size;
+
+        if(size_ > 0)
+        {
+            void* addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            if(addr != MAP_FAILED)
+            {
+                data_ = static_cast<const char*>(addr);
+                mapped_ = true;
+            }
+            else
+            {
+                //some filesystems do not support mmap, fall back to a private copy
+                buffer_.resize(size_);
+                size_t nbRead = 0;
+                while(nbRead < size_)
+                {
+                    ssize_t n = read(fd, buffer_.data() + nbRead, size_ - nbRead);
+                    if(n <= 0) break;
+                    nbRead += n;
+                }
+                if(nbRead != size_)
+                {
+                    close(fd);
+                    THROW_TTEXCEPTION("ERROR: Unable to read file: \"" + file + "\"");
+                }
+                data_ = buffer_.data();
+            }
+        }
+
+        //the mapping stays valid after the file is closed
+        close(fd);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if(mapped_) munmap(const_cast<char*>(data_), size_);
+    }
+
+    const char* MappedFile::data() const
+    {
+        return data_;
+    }
+
+    size_t MappedFile::size() const
+    {
+        return size_;
+    }
+
 }
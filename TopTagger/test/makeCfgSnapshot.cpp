@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <cinttypes>
+#include <string>
+#include <memory>
+
+#include "TopTagger/CfgParser/include/CfgDocument.hh"
+#include "TopTagger/CfgParser/include/TTException.h"
+
+//Convert a top tagger configuration file into a binary snapshot which TopTagger::setCfgFile loads without parsing
+//usage: makeCfgSnapshot [input cfg file] [output snapshot file]
+
+bool readFile(const std::string& fileName, std::string& contents)
+{
+    FILE *f = fopen(fileName.c_str(), "rb");
+    if(!f) return false;
+
+    char buff[65536];
+    for(size_t nRead; (nRead = fread(buff, 1, sizeof(buff), f)) > 0;)
+    {
+        contents.append(buff, nRead);
+    }
+    fclose(f);
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc != 3)
+    {
+        printf("usage: %s [input cfg file] [output snapshot file]\n", argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        std::string cfgText;
+        if(!readFile(argv[1], cfgText))
+        {
+            printf("Unable to open input file \"%s\"\n", argv[1]);
+            return 1;
+        }
+
+        std::unique_ptr<cfg::CfgDocument> cfgDoc = cfg::CfgDocument::parseDocument(cfgText);
+        if(!cfgDoc)
+        {
+            printf("Input file \"%s\" does not contain a configuration\n", argv[1]);
+            return 1;
+        }
+
+        std::string snapshot = cfgDoc->snapshot();
+
+        //Check that the snapshot can be read back before writing it
+        cfg::CfgDocument::loadSnapshot(snapshot);
+
+        FILE *f = fopen(argv[2], "wb");
+        if(!f || fwrite(snapshot.data(), 1, snapshot.size(), f) != snapshot.size())
+        {
+            printf("Unable to write output file \"%s\"\n", argv[2]);
+            if(f) fclose(f);
+            return 1;
+        }
+        fclose(f);
+
+        printf("Wrote %zu bytes to \"%s\", content hash %016" PRIx64 "\n", snapshot.size(), argv[2], cfg::CfgDocument::snapshotHash(snapshot));
+    }
+    catch(const TTException& e)
+    {
+        e.print();
+        return 1;
+    }
+
+    return 0;
+}
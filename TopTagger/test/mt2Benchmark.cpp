@@ -0,0 +1,208 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TLorentzVector.h"
+
+#include "TopTagger/TopTagger/interface/TopTagger.h"
+#include "TopTagger/TopTagger/interface/TopTaggerResults.h"
+#include "TopTagger/TopTagger/interface/TopTaggerUtilities.h"
+
+#include "TopTagger/CfgParser/include/TTException.h"
+
+//Benchmark of the reduced precision MT2 modes against the exact calculation
+//The final tops are found with a cut based configuration so that no MVA inputs are needed, the missing HT of the AK4 jets is used as MET
+//usage: mt2Benchmark [input file] [number of repetitions per event]
+
+const std::string cfgText =
+    "TopTagger\n"
+    "{\n"
+    "    module[0] = \"TTMBasicClusterAlgo\"\n"
+    "    module[1] = \"TTMHEPRequirements\"\n"
+    "    module[2] = \"TTMAK8TopFilter\"\n"
+    "    module[3] = \"TTMOverlapResolution\"\n"
+    "    module[4] = \"TTMRemainingSystem\"\n"
+    "}\n"
+    "Common\n"
+    "{\n"
+    "    mW = 80.385\n"
+    "    mt = 173.5\n"
+    "    maxTopEta = 2.0\n"
+    "    dRMatch = 0.4\n"
+    "    dRMatchAK8 = 0.8\n"
+    "}\n"
+    "TTMBasicClusterAlgo\n"
+    "{\n"
+    "    doTrijet = true\n"
+    "    minTopCandMass = 100\n"
+    "    maxTopCandMass = 250\n"
+    "    minTrijetAK4JetPt = 20\n"
+    "    midTrijetAK4JetPt = 30\n"
+    "    maxTrijetAK4JetPt = 40\n"
+    "    dRMaxTrijet = 1.5\n"
+    "    doMonojet = true\n"
+    "    useDeepAK8 = true\n"
+    "    deepAK8TopDisc = 0.6\n"
+    "    minAK8TopMass = 105\n"
+    "    maxAK8TopMass = 210\n"
+    "    minAK8TopPt = 400\n"
+    "}\n"
+    "TTMHEPRequirements\n"
+    "{\n"
+    "    Rmin = 0.85\n"
+    "    Rmax = 1.25\n"
+    "    csvThreshold = 0.8484\n"
+    "    bEtaCut = 2.4\n"
+    "    maxNbInTop = 1\n"
+    "    doTrijet = true\n"
+    "}\n"
+    "TTMOverlapResolution\n"
+    "{\n"
+    "    sortMethod = \"topMass\"\n"
+    "}\n"
+    "TTMRemainingSystem\n"
+    "{\n"
+    "    csvThreshold = 0.8484\n"
+    "    lowRsysMass = 50\n"
+    "    highRsysMass = 220\n"
+    "    dRMaxRsys = 1.5\n"
+    "}\n";
+
+struct BenchmarkMode
+{
+    std::string name;
+    ttUtility::MT2Precision precision;
+    double time;
+    double sumResidual;
+    double maxResidual;
+    double maxErrorBound;
+    int nBeyondBound;
+};
+
+int main(int argc, char* argv[])
+{
+    const char* inputFile = (argc > 1) ? argv[1] : "exampleInputs.root";
+    const int nRepeat     = (argc > 2) ? atoi(argv[2]) : 1000;
+
+    TFile *tf = TFile::Open(inputFile);
+    if(!tf)
+    {
+        printf("Unable to open input file \"%s\"\n", inputFile);
+        return 1;
+    }
+    TTree *tree = (TTree*)tf->Get("slimmedTuple");
+
+    tree->SetBranchStatus("*", 0);
+
+    std::vector<TLorentzVector>** AK4JetLV = new std::vector<TLorentzVector>*();
+    std::vector<float>** AK4JetBtag = new std::vector<float>*();
+    std::vector<TLorentzVector>** AK8JetLV = new std::vector<TLorentzVector>*();
+    std::vector<float>** AK8JetSoftdropMass = new std::vector<float>*();
+    std::vector<float>** AK8JetDeepAK8Top = new std::vector<float>*();
+    std::vector<float>** AK8JetDeepAK8W = new std::vector<float>*();
+    std::vector<std::vector<TLorentzVector>>** AK8SubjetLV = new std::vector<std::vector<TLorentzVector>>*();
+
+    tree->SetBranchStatus( "ak4jetsLVec", 1);
+    tree->SetBranchAddress("ak4jetsLVec", AK4JetLV);
+    tree->SetBranchStatus( "ak4recoJetsBtag", 1);
+    tree->SetBranchAddress("ak4recoJetsBtag", AK4JetBtag);
+    tree->SetBranchStatus( "ak8JetsLVec", 1);
+    tree->SetBranchAddress("ak8JetsLVec", AK8JetLV);
+    tree->SetBranchStatus( "ak8SubJetsLVec", 1);
+    tree->SetBranchAddress("ak8SubJetsLVec", AK8SubjetLV);
+    tree->SetBranchStatus( "ak8DeepAK8Top", 1);
+    tree->SetBranchAddress("ak8DeepAK8Top", AK8JetDeepAK8Top);
+    tree->SetBranchStatus( "ak8DeepAK8W", 1);
+    tree->SetBranchAddress("ak8DeepAK8W", AK8JetDeepAK8W);
+    tree->SetBranchStatus( "ak8softDropMass", 1);
+    tree->SetBranchAddress("ak8softDropMass", AK8JetSoftdropMass);
+
+    //The first mode is the exact calculation which the others are compared to
+    std::vector<BenchmarkMode> modes = {
+        {"exact",             ttUtility::MT2Precision(),              0.0, 0.0, 0.0, 0.0, 0},
+        {"abs 0.1 GeV",       ttUtility::MT2Precision(0.1),           0.0, 0.0, 0.0, 0.0, 0},
+        {"abs 1 GeV",         ttUtility::MT2Precision(1.0),           0.0, 0.0, 0.0, 0.0, 0},
+        {"abs 10 GeV",        ttUtility::MT2Precision(10.0),          0.0, 0.0, 0.0, 0.0, 0},
+        {"rel 0.1%",          ttUtility::MT2Precision(0.0, 0.001),    0.0, 0.0, 0.0, 0.0, 0},
+        {"rel 1%",            ttUtility::MT2Precision(0.0, 0.01),     0.0, 0.0, 0.0, 0.0, 0},
+        {"max 10 iterations", ttUtility::MT2Precision(0.0, 0.0, 10),  0.0, 0.0, 0.0, 0.0, 0},
+    };
+
+    TopTagger tt;
+
+    int Nevt = 0;
+    int nWithTops = 0;
+    try
+    {
+        tt.setCfgFileDirect(cfgText);
+
+        while(tree->GetEntry(Nevt))
+        {
+            ++Nevt;
+
+            ttUtility::ConstAK4Inputs<float> AK4Inputs(**AK4JetLV, **AK4JetBtag);
+            ttUtility::ConstAK8Inputs<float> AK8Inputs(**AK8JetLV, **AK8JetDeepAK8Top, **AK8JetDeepAK8W, **AK8JetSoftdropMass, **AK8SubjetLV);
+
+            tt.runTagger(ttUtility::packageConstituents(AK4Inputs, AK8Inputs));
+            const TopTaggerResults& ttr = tt.getResults();
+            if(ttr.getTops().size() > 0) ++nWithTops;
+
+            //missing HT of the AK4 jets
+            double mhtX = 0.0, mhtY = 0.0;
+            for(const TLorentzVector& jet : **AK4JetLV)
+            {
+                mhtX -= jet.Px();
+                mhtY -= jet.Py();
+            }
+            TLorentzVector metLVec;
+            metLVec.SetPxPyPzE(mhtX, mhtY, 0.0, sqrt(mhtX*mhtX + mhtY*mhtY));
+
+            const double exactMT2 = ttUtility::calculateMT2(ttr, metLVec);
+
+            for(BenchmarkMode& mode : modes)
+            {
+                double mt2 = 0.0, errorBound = 0.0;
+                auto start = std::chrono::steady_clock::now();
+                for(int iRepeat = 0; iRepeat < nRepeat; ++iRepeat) mt2 = ttUtility::calculateMT2(ttr, metLVec, mode.precision, &errorBound);
+                mode.time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                const double residual = fabs(mt2 - exactMT2);
+                mode.sumResidual += residual;
+                mode.maxResidual = std::max(mode.maxResidual, residual);
+                mode.maxErrorBound = std::max(mode.maxErrorBound, errorBound);
+                if(residual > errorBound*(1 + 1e-12) + 1e-9) ++mode.nBeyondBound;
+            }
+        }
+    }
+    catch(const TTException& e)
+    {
+        e.print();
+        printf("Terminating run\n");
+        fflush(stdout);
+
+        exit(1);
+    }
+
+    printf("%d events, %d with at least one top, %d repetitions per event\n\n", Nevt, nWithTops, nRepeat);
+    printf("%-20s %12s %9s %16s %15s %16s %14s\n", "mode", "time [us/evt]", "speedup", "mean |res| [GeV]", "max |res| [GeV]", "max bound [GeV]", "beyond bound");
+    for(const BenchmarkMode& mode : modes)
+    {
+        const double time = 1e6*mode.time/(static_cast<double>(Nevt)*nRepeat);
+        printf("%-20s %12.3f %9.2f %16.4g %15.4g %16.4g %14d\n", mode.name.c_str(), time, modes[0].time/mode.time, mode.sumResidual/Nevt, mode.maxResidual, mode.maxErrorBound, mode.nBeyondBound);
+    }
+
+    delete AK4JetLV;
+    delete AK4JetBtag;
+    delete AK8JetLV;
+    delete AK8SubjetLV;
+    delete AK8JetDeepAK8Top;
+    delete AK8JetDeepAK8W;
+    delete AK8JetSoftdropMass;
+
+    return 0;
+}